@@ -0,0 +1,128 @@
+// Пропускная способность (файлов/с) на мелких файлах 1–64 КиБ:
+//  - baseline: file_to_nibbles + Scheme(std::vector<Nibble>) — путь GUI до
+//    появления потокового подсчёта;
+//  - stream:   TransitionCounter + nibble_io::feed_file на каждый файл;
+//  - context:  один AnalysisContext на весь поток файлов.
+// Для каждого варианта печатается число выделений памяти на файл.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// core
+#include "analysis_context.h"
+#include "nibbles_io.h"
+#include "scheme.h"
+#include "transition_counter.h"
+
+namespace
+{
+
+std::atomic<std::uint64_t> g_allocations{0};
+
+} // namespace
+
+// Считаем все выделения в процессе
+void* operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+
+namespace fs = std::filesystem;
+
+// Чтобы компилятор не выкинул результат
+volatile double g_sink = 0.0;
+
+std::vector<std::string> make_files(const fs::path& dir, std::size_t size, std::size_t count)
+{
+    fs::create_directories(dir);
+
+    std::mt19937_64 rng(size);
+    std::vector<std::uint8_t> buf(size);
+    std::vector<std::string> paths;
+    paths.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        // Наполовину случайные, наполовину структурированные данные
+        for (std::size_t j = 0; j < size; ++j) {
+            buf[j] = (j % 2) ? static_cast<std::uint8_t>(rng()) : static_cast<std::uint8_t>(j & 0x3F);
+        }
+
+        const fs::path p = dir / ("f" + std::to_string(i) + ".bin");
+        std::ofstream f(p, std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char*>(buf.data()), static_cast<std::streamsize>(buf.size()));
+        paths.push_back(p.string());
+    }
+    return paths;
+}
+
+template <class Fn>
+void run(const char* name, const std::vector<std::string>& paths, int rounds, Fn&& fn)
+{
+    // Прогрев: кэш страниц и первичные выделения контекста
+    for (const auto& p : paths) fn(p);
+
+    const std::uint64_t allocs_before = g_allocations.load();
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto& p : paths) fn(p);
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    const std::uint64_t allocs = g_allocations.load() - allocs_before;
+
+    const double files = static_cast<double>(paths.size()) * rounds;
+    const double sec   = std::chrono::duration<double>(t1 - t0).count();
+    std::printf("  %-9s %12.0f files/s  %8.2f allocs/file\n",
+                name, files / sec, static_cast<double>(allocs) / files);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const std::size_t count  = (argc > 1) ? static_cast<std::size_t>(std::atoi(argv[1])) : 2000;
+    const int         rounds = (argc > 2) ? std::atoi(argv[2]) : 5;
+
+    const fs::path root = fs::temp_directory_path() / "nibbles_bench";
+    AnalysisContext ctx;
+
+    for (const std::size_t size : { 1024u, 4096u, 16384u, 65536u }) {
+        const auto paths = make_files(root / std::to_string(size), size, count);
+        std::printf("%zu files x %zu KiB, %d rounds\n", count, size / 1024, rounds);
+
+        run("baseline", paths, rounds, [](const std::string& p) {
+            const Scheme sch(nibble_io::file_to_nibbles(p));
+            g_sink = g_sink + sch.entropy_joint();
+        });
+
+        run("stream", paths, rounds, [](const std::string& p) {
+            TransitionCounter counter;
+            nibble_io::feed_file(p, counter);
+            g_sink = g_sink + counter.scheme().entropy_joint();
+        });
+
+        run("context", paths, rounds, [&ctx](const std::string& p) {
+            ctx.analyze_file(p);
+            g_sink = g_sink + ctx.scheme().entropy_joint();
+        });
+    }
+
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    return 0;
+}
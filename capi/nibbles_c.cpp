@@ -0,0 +1,147 @@
+#include "nibbles_c.h"
+
+#include <new>
+
+// core
+#include "scheme.h"
+#include "transition_counter.h"
+
+// Дескриптор — просто потоковый счётчик из core
+struct nibbles_analyzer
+{
+    TransitionCounter counter;
+};
+
+namespace
+{
+
+void fill_entropy(const Scheme& sch, nibbles_entropy* out)
+{
+    out->joint       = sch.entropy_joint();
+    out->prev        = sch.entropy_prev();
+    out->conditional = sch.entropy_conditional_nibble();
+    out->per_bit     = sch.entropy_per_bit();
+    out->max         = sch.entropy_max();
+}
+
+void fill_counts(const TransitionCounter::Counts& counts, uint64_t out[256])
+{
+    for (int a = 0; a < 16; ++a) {
+        for (int b = 0; b < 16; ++b) {
+            out[a * 16 + b] = counts[a][b];
+        }
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+uint32_t nibbles_abi_version(void)
+{
+    return NIBBLES_ABI_VERSION;
+}
+
+const char* nibbles_status_string(nibbles_status status)
+{
+    switch (status) {
+    case NIBBLES_OK:                   return "ok";
+    case NIBBLES_ERR_INVALID_ARGUMENT: return "invalid argument";
+    case NIBBLES_ERR_OUT_OF_MEMORY:    return "out of memory";
+    }
+    return "unknown status";
+}
+
+nibbles_status nibbles_analyzer_create(nibbles_analyzer** out)
+{
+    if (!out) return NIBBLES_ERR_INVALID_ARGUMENT;
+
+    *out = new (std::nothrow) nibbles_analyzer();
+    return *out ? NIBBLES_OK : NIBBLES_ERR_OUT_OF_MEMORY;
+}
+
+void nibbles_analyzer_destroy(nibbles_analyzer* analyzer)
+{
+    delete analyzer;
+}
+
+nibbles_status nibbles_analyzer_reset(nibbles_analyzer* analyzer)
+{
+    if (!analyzer) return NIBBLES_ERR_INVALID_ARGUMENT;
+
+    analyzer->counter.reset();
+    return NIBBLES_OK;
+}
+
+nibbles_status nibbles_analyzer_feed(nibbles_analyzer* analyzer, const uint8_t* data, size_t size)
+{
+    if (!analyzer || (!data && size)) return NIBBLES_ERR_INVALID_ARGUMENT;
+
+    analyzer->counter.feed(data, size);
+    return NIBBLES_OK;
+}
+
+nibbles_status nibbles_analyzer_processed(const nibbles_analyzer* analyzer, uint64_t* out_bytes)
+{
+    if (!analyzer || !out_bytes) return NIBBLES_ERR_INVALID_ARGUMENT;
+
+    *out_bytes = analyzer->counter.processed();
+    return NIBBLES_OK;
+}
+
+nibbles_status nibbles_analyzer_transitions(const nibbles_analyzer* analyzer, uint64_t* out_transitions)
+{
+    if (!analyzer || !out_transitions) return NIBBLES_ERR_INVALID_ARGUMENT;
+
+    *out_transitions = analyzer->counter.transitions();
+    return NIBBLES_OK;
+}
+
+nibbles_status nibbles_analyzer_counts(const nibbles_analyzer* analyzer, uint64_t out_counts[256])
+{
+    if (!analyzer || !out_counts) return NIBBLES_ERR_INVALID_ARGUMENT;
+
+    fill_counts(analyzer->counter.counts(), out_counts);
+    return NIBBLES_OK;
+}
+
+nibbles_status nibbles_analyzer_probabilities(const nibbles_analyzer* analyzer,
+                                              double out_joint[256],
+                                              double out_conditional[256])
+{
+    if (!analyzer) return NIBBLES_ERR_INVALID_ARGUMENT;
+
+    // Scheme целиком на стеке — без выделений памяти
+    const Scheme sch = analyzer->counter.scheme();
+    for (int a = 0; a < 16; ++a) {
+        for (int b = 0; b < 16; ++b) {
+            if (out_joint)       out_joint[a * 16 + b]       = sch.table()[a][b];
+            if (out_conditional) out_conditional[a * 16 + b] = sch.table_conditional()[a][b];
+        }
+    }
+    return NIBBLES_OK;
+}
+
+nibbles_status nibbles_analyzer_entropy(const nibbles_analyzer* analyzer, nibbles_entropy* out)
+{
+    if (!analyzer || !out) return NIBBLES_ERR_INVALID_ARGUMENT;
+
+    fill_entropy(analyzer->counter.scheme(), out);
+    return NIBBLES_OK;
+}
+
+nibbles_status nibbles_analyze_buffer(const uint8_t* data, size_t size,
+                                      uint64_t out_counts[256],
+                                      nibbles_entropy* out_entropy)
+{
+    if ((!data && size) || (!out_counts && !out_entropy)) return NIBBLES_ERR_INVALID_ARGUMENT;
+
+    TransitionCounter counter;
+    counter.feed(data, size);
+
+    if (out_counts)  fill_counts(counter.counts(), out_counts);
+    if (out_entropy) fill_entropy(counter.scheme(), out_entropy);
+    return NIBBLES_OK;
+}
+
+} // extern "C"
@@ -0,0 +1,95 @@
+#ifndef NIBBLES_C_H
+#define NIBBLES_C_H
+
+/*
+ * Стабильный C API над core для встраивания (Python ctypes/cffi, Go cgo и т.п.).
+ *
+ * - Буферы принадлежат вызывающему: данные читаются напрямую, без копии.
+ * - Анализатор можно кормить кусками и переиспользовать после reset.
+ * - Результаты пишутся в массивы вызывающего; на вызов память не выделяется
+ *   (выделение только в nibbles_analyzer_create).
+ * - Глобального состояния нет: разные дескрипторы можно использовать из разных
+ *   потоков одновременно. Один дескриптор — только из одного потока за раз.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(NIBBLES_C_BUILD)
+#    define NIBBLES_API __declspec(dllexport)
+#  else
+#    define NIBBLES_API __declspec(dllimport)
+#  endif
+#else
+#  define NIBBLES_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Увеличивается при несовместимом изменении ABI */
+#define NIBBLES_ABI_VERSION 1u
+
+typedef enum nibbles_status
+{
+    NIBBLES_OK                   = 0,
+    NIBBLES_ERR_INVALID_ARGUMENT = 1,
+    NIBBLES_ERR_OUT_OF_MEMORY    = 2
+} nibbles_status;
+
+/* Непрозрачный дескриптор анализатора */
+typedef struct nibbles_analyzer nibbles_analyzer;
+
+/* Энтропии схемы переходов, бит */
+typedef struct nibbles_entropy
+{
+    double joint;       /* H(S_i, S_{i+1}), на пару          */
+    double prev;        /* H(S_i), на ниббл                   */
+    double conditional; /* H(S_{i+1} | S_i), на ниббл         */
+    double per_bit;     /* conditional / 4                    */
+    double max;         /* максимум на ниббл (4)              */
+} nibbles_entropy;
+
+NIBBLES_API uint32_t nibbles_abi_version(void);
+NIBBLES_API const char* nibbles_status_string(nibbles_status status);
+
+NIBBLES_API nibbles_status nibbles_analyzer_create(nibbles_analyzer** out);
+NIBBLES_API void nibbles_analyzer_destroy(nibbles_analyzer* analyzer);
+
+/* Сбросить счётчики для повторного использования дескриптора */
+NIBBLES_API nibbles_status nibbles_analyzer_reset(nibbles_analyzer* analyzer);
+
+/* Добавить очередной кусок байтов; переход через границу кусков учитывается */
+NIBBLES_API nibbles_status nibbles_analyzer_feed(nibbles_analyzer* analyzer,
+                                                 const uint8_t* data, size_t size);
+
+/* Сколько байтов подано и сколько переходов насчитано */
+NIBBLES_API nibbles_status nibbles_analyzer_processed(const nibbles_analyzer* analyzer,
+                                                      uint64_t* out_bytes);
+NIBBLES_API nibbles_status nibbles_analyzer_transitions(const nibbles_analyzer* analyzer,
+                                                        uint64_t* out_transitions);
+
+/* Счётчики N_ab в порядке строк: out[a * 16 + b] */
+NIBBLES_API nibbles_status nibbles_analyzer_counts(const nibbles_analyzer* analyzer,
+                                                   uint64_t out_counts[256]);
+
+/* P(a,b) и P(b|a) в порядке строк; любой из массивов может быть NULL */
+NIBBLES_API nibbles_status nibbles_analyzer_probabilities(const nibbles_analyzer* analyzer,
+                                                          double out_joint[256],
+                                                          double out_conditional[256]);
+
+NIBBLES_API nibbles_status nibbles_analyzer_entropy(const nibbles_analyzer* analyzer,
+                                                    nibbles_entropy* out);
+
+/* Разовый анализ буфера без дескриптора; out_counts может быть NULL */
+NIBBLES_API nibbles_status nibbles_analyze_buffer(const uint8_t* data, size_t size,
+                                                  uint64_t out_counts[256],
+                                                  nibbles_entropy* out_entropy);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* NIBBLES_C_H */
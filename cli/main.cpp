@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// core
+#include "analysis_context.h"
+#include "nibble_container.h"
+#include "nibble_segmentation.h"
+
+namespace
+{
+
+int usage()
+{
+    std::cerr <<
+        "Usage:\n"
+        "  nibbles_cli pack <archive.nibbles> <file|dir>...\n"
+        "  nibbles_cli list <archive.nibbles>\n"
+        "  nibbles_cli extract <archive.nibbles> <dest_dir> [member...]\n"
+        "  nibbles_cli segment [--json] <file>...\n"
+        "  nibbles_cli stats <file>...\n";
+    return 2;
+}
+
+int cmd_pack(const std::vector<std::string>& args)
+{
+    namespace fs = std::filesystem;
+
+    if (args.size() < 2) return usage();
+
+    // Файлы кладём под своим именем, каталоги — с путями относительно
+    // родителя каталога (dir/sub/file); сам архив пропускается
+    std::vector<std::pair<std::string, std::string>> files;
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        const fs::path src = fs::u8path(args[i]);
+        if (fs::is_directory(src)) {
+            // Каноничный путь: у "dir/", "." и ".." тоже есть имя
+            const std::string name = fs::weakly_canonical(src).filename().generic_u8string();
+            NibbleContainerArchiever::collect_directory(src.u8string(), name.empty() ? name : name + "/",
+                                                        args[0], files);
+        } else {
+            files.emplace_back(src.u8string(), src.filename().u8string());
+        }
+    }
+
+    // Стабильный порядок членов независимо от файловой системы
+    std::sort(files.begin(), files.end(),
+              [](const auto& a, const auto& b) { return a.second < b.second; });
+
+    NibbleContainerArchiever archiever;
+    archiever.pack(files, args[0]);
+
+    std::cout << "Packed " << files.size() << " file(s) into " << args[0] << "\n";
+    return 0;
+}
+
+int cmd_list(const std::vector<std::string>& args)
+{
+    if (args.size() != 1) return usage();
+
+    NibbleContainerArchiever archiever;
+    std::uint64_t total = 0;
+    std::uint64_t packed = 0;
+    for (const auto& e : archiever.list(args[0])) {
+        std::cout << e.size << "\t" << e.packed_size << "\t" << e.name << "\n";
+        total  += e.size;
+        packed += e.packed_size;
+    }
+    std::cout << total << "\t" << packed << "\t(total)\n";
+    return 0;
+}
+
+int cmd_extract(const std::vector<std::string>& args)
+{
+    namespace fs = std::filesystem;
+
+    if (args.size() < 2) return usage();
+
+    NibbleContainerArchiever archiever;
+    if (args.size() == 2) {
+        archiever.unpack_all(args[0], args[1]);
+        return 0;
+    }
+
+    // Индекс читаем один раз; член ложится в dest по своему относительному
+    // пути, как при распаковке всего контейнера
+    const std::vector<NibbleContainerEntry> entries = archiever.list(args[0]);
+    for (std::size_t i = 2; i < args.size(); ++i) {
+        const auto it = std::find_if(entries.begin(), entries.end(),
+                                     [&](const NibbleContainerEntry& e) { return e.name == args[i]; });
+        if (it == entries.end()) {
+            throw std::runtime_error("No such member in container: " + args[i]);
+        }
+        if (!NibbleContainerArchiever::is_safe_name(it->name)) {
+            throw std::runtime_error("Invalid member name: " + it->name);
+        }
+
+        const fs::path target = fs::u8path(args[1]) / fs::u8path(it->name);
+        fs::create_directories(target.parent_path());
+        archiever.extract_to(args[0], *it, target.u8string());
+    }
+    return 0;
+}
+
+std::string json_escape(const std::string& s)
+{
+    std::string out;
+    for (const char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out;
+}
+
+// Области однородной энтропии: таблица для человека или JSON (по объекту
+// на строку) для пакетной обработки
+int cmd_segment(const std::vector<std::string>& args)
+{
+    bool json = false;
+    std::vector<std::string> paths;
+    for (const auto& a : args) {
+        if (a == "--json") json = true;
+        else paths.push_back(a);
+    }
+    if (paths.empty()) return usage();
+
+    std::cout << std::fixed << std::setprecision(4);
+    for (const auto& path : paths) {
+        const auto segments = nibble_segmentation::segment_file(path);
+
+        if (json) {
+            std::cout << "{\"file\":\"" << json_escape(path) << "\",\"segments\":[";
+            for (std::size_t i = 0; i < segments.size(); ++i) {
+                const auto& s = segments[i];
+                std::cout << (i ? "," : "")
+                          << "{\"begin\":" << s.begin
+                          << ",\"end\":" << s.end
+                          << ",\"label\":\"" << nibble_segmentation::label_name(s.label) << "\""
+                          << ",\"entropy_joint\":" << s.joint
+                          << ",\"entropy_conditional\":" << s.conditional << "}";
+            }
+            std::cout << "]}\n";
+            continue;
+        }
+
+        std::cout << path << "\n";
+        for (const auto& s : segments) {
+            std::cout << "  " << std::setw(12) << s.begin << " - " << std::setw(12) << s.end
+                      << "  " << std::setw(12) << std::left << nibble_segmentation::label_name(s.label) << std::right
+                      << "  H=" << s.joint << "  H_cond=" << s.conditional << "\n";
+        }
+    }
+    return 0;
+}
+
+// Энтропия множества мелких файлов: один контекст на весь список,
+// по строке на файл (путь, размер, H, H_cond через табуляцию)
+int cmd_stats(const std::vector<std::string>& args)
+{
+    if (args.empty()) return usage();
+
+    // Нечитаемый файл не прерывает пакетный прогон: ошибка — в stderr,
+    // код возврата в конце — 1
+    AnalysisContext ctx;
+    int status = 0;
+    std::cout << std::fixed << std::setprecision(4);
+    for (const auto& path : args) {
+        try
+        {
+            const TransitionCounter& counter = ctx.analyze_file(path);
+            const Scheme sch = counter.scheme();
+            std::cout << path << '\t' << counter.processed()
+                      << '\t' << sch.entropy_joint()
+                      << '\t' << sch.entropy_conditional_nibble() << '\n';
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error: " << e.what() << "\n";
+            status = 1;
+        }
+    }
+    return status;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) return usage();
+
+    const std::string cmd = argv[1];
+    const std::vector<std::string> args(argv + 2, argv + argc);
+
+    try
+    {
+        if (cmd == "pack")    return cmd_pack(args);
+        if (cmd == "list")    return cmd_list(args);
+        if (cmd == "extract") return cmd_extract(args);
+        if (cmd == "segment") return cmd_segment(args);
+        if (cmd == "stats")   return cmd_stats(args);
+        return usage();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#ifndef ANALYSIS_CONTEXT_H
+#define ANALYSIS_CONTEXT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include "scheme.h"
+#include "transition_counter.h"
+
+// Переиспользуемый контекст анализа для потока мелких файлов.
+//
+// На каждый файл обычный путь создаёт std::vector<uint8_t> (read_to_bin),
+// std::vector<Nibble> (convert_to_nibbles), Scheme и std::ifstream. Контекст
+// выделяет буфер ввода один раз и дальше только сбрасывает счётчики, а файл
+// читает системными вызовами кусками размером с буфер. После конструктора
+// analyze_file() не обращается к куче (кроме ошибок — исключение с текстом).
+//
+// Один контекст — на один рабочий поток.
+class AnalysisContext
+{
+public:
+    explicit AnalysisContext(std::size_t buffer_size = 64 * 1024)
+        : m_buffer(buffer_size ? buffer_size : 1)
+    {}
+
+    // Посчитать переходы по файлу; результат живёт до следующего вызова
+    const TransitionCounter& analyze_file(const std::string& path)
+    {
+        return analyze_file(path.c_str());
+    }
+
+    const TransitionCounter& analyze_file(const char* path)
+    {
+        m_counter.reset();
+
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("Cannot open file: ") + path);
+        }
+
+        while (true) {
+            const ssize_t got = ::read(fd, m_buffer.data(), m_buffer.size());
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                ::close(fd);
+                throw std::runtime_error(std::string("Failed to read file: ") + path);
+            }
+            if (got == 0) break;
+            m_counter.feed(m_buffer.data(), static_cast<std::size_t>(got));
+        }
+        ::close(fd);
+#else
+        // Без POSIX: stdio без собственного буфера FILE — читаем прямо в наш
+        std::FILE* f = std::fopen(path, "rb");
+        if (!f) {
+            throw std::runtime_error(std::string("Cannot open file: ") + path);
+        }
+        std::setvbuf(f, nullptr, _IONBF, 0);
+
+        std::size_t got = 0;
+        while ((got = std::fread(m_buffer.data(), 1, m_buffer.size(), f)) > 0) {
+            m_counter.feed(m_buffer.data(), got);
+        }
+        const bool failed = std::ferror(f) != 0;
+        std::fclose(f);
+        if (failed) {
+            throw std::runtime_error(std::string("Failed to read file: ") + path);
+        }
+#endif
+
+        return m_counter;
+    }
+
+    // То же для буфера в памяти (без копии)
+    const TransitionCounter& analyze(const std::uint8_t* data, std::size_t size)
+    {
+        m_counter.reset();
+        m_counter.feed(data, size);
+        return m_counter;
+    }
+
+    const TransitionCounter& counter() const { return m_counter; }
+
+    // Scheme целиком на стеке вызывающего — без выделений памяти
+    Scheme scheme() const { return m_counter.scheme(); }
+
+private:
+    std::vector<std::uint8_t> m_buffer;
+    TransitionCounter         m_counter;
+};
+
+#endif // ANALYSIS_CONTEXT_H
@@ -0,0 +1,399 @@
+#pragma once
+#ifndef NIBBLE_CACHE_H
+#define NIBBLE_CACHE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+#include "nibble_hash.h"
+#include "nibble_incremental.h"
+#include "nibble_segmentation.h"
+#include "nibbles_io.h"
+
+// Дисковый кэш результатов анализа: повторное открытие неизменного файла
+// не перечитывает его, а выросший файл дочитывается с места остановки.
+//
+// Ключ — идентичность файла (st_dev + st_ino; без POSIX — каноничный путь),
+// поэтому у файла ровно одна запись, и новые результаты её перезаписывают.
+// В записи хранятся метаданные файла на момент анализа (размер, mtime, ctime).
+// Запись годится, если они совпадают с текущими (файл не трогали), или если
+// файл стал длиннее обработанного — тогда продолжить с processed() можно после
+// проверки отпечатка префикса (nibble_incremental::update). Любое другое
+// отличие — промах: выборочному хэшу содержимого мы не доверяем. При verify в
+// запись добавляется полный FNV-1a обработанного префикса и сверяется при
+// каждом попадании (медленно, но точно).
+//
+// Ограничение без verify: если файл изменили в середине и затем дописали, он
+// выглядит выросшим, и обработанный префикс проверяется только отпечатком —
+// длиной и первыми/последними 64 КиБ. Такая правка останется незамеченной;
+// find() с verify читает префикс целиком и её обнаруживает.
+//
+// Одна запись — один файл <ключ>.nbr в каталоге кэша. Запись идёт во временный
+// файл и атомарно переименовывается, поэтому несколько экземпляров программы
+// могут работать с одним каталогом без блокировок: читатель видит либо старую,
+// либо новую запись целиком. LRU: попадание обновляет время изменения записи,
+// а evict() удаляет самые старые, пока кэш не уложится в лимит.
+
+// Метаданные файла; снимаются до чтения, чтобы любая запись в файл во время
+// или после анализа дала отличие
+struct FileStat
+{
+    std::uint64_t dev      = 0;
+    std::uint64_t ino      = 0; // без POSIX — хэш каноничного пути
+    std::uint64_t size     = 0;
+    std::int64_t  mtime_ns = 0;
+    std::int64_t  ctime_ns = 0;
+
+    static FileStat of(const std::string& path);
+
+    bool same_file(const FileStat& o) const { return dev == o.dev && ino == o.ino; }
+
+    bool operator==(const FileStat& o) const
+    {
+        return same_file(o) && size == o.size && mtime_ns == o.mtime_ns && ctime_ns == o.ctime_ns;
+    }
+    bool operator!=(const FileStat& o) const { return !(*this == o); }
+};
+
+struct CachedResult
+{
+    // Счётчики и префиксы областей: из них берутся N_ab и области, с них же
+    // продолжается дочитывание
+    nibble_segmentation::Segmenter segmenter{0};
+    std::uint64_t                  fingerprint = 0; // prefix_fingerprint(path, segmenter.processed())
+    FileStat                       stat;            // файл перед анализом
+};
+
+class ResultCache
+{
+public:
+    static constexpr std::uint64_t DEFAULT_MAX_BYTES = std::uint64_t{256} << 20;
+
+    explicit ResultCache(std::string dir,
+                         std::uint64_t max_bytes = DEFAULT_MAX_BYTES,
+                         bool verify = false)
+        : m_dir(std::filesystem::u8path(dir))
+        , m_max_bytes(max_bytes)
+        , m_verify(verify)
+    {}
+
+    // Запись для файла: либо файл не менялся, либо только вырос (тогда
+    // segmenter.processed() меньше размера файла)
+    std::optional<CachedResult> find(const std::string& path) const;
+    // Сохранить результат под ключом result.stat
+    void store(const std::string& path, const CachedResult& result) const;
+    // Удалить самые давно использованные записи сверх лимита
+    void evict() const;
+
+    static std::uint64_t file_key(const FileStat& stat);
+
+private:
+    std::filesystem::path entry_path(std::uint64_t key) const;
+
+    static std::uint64_t full_hash(const std::string& path, std::uint64_t length);
+
+    std::filesystem::path m_dir;
+    std::uint64_t         m_max_bytes;
+    bool                  m_verify;
+};
+
+namespace nibble_cache_detail
+{
+
+const char          MAGIC[8]       = { 'N', 'B', 'L', 'C', 'A', 'C', 'H', 'E' };
+const std::uint64_t VERSION        = 2;
+const char          ENTRY_SUFFIX[] = ".nbr";
+
+// Приёмник для nibble_io::feed_file_from: считает FNV-1a по потоку
+struct HashSink
+{
+    std::uint64_t h = nibble_hash::FNV_OFFSET_BASIS;
+
+    void feed(const std::uint8_t* data, std::size_t size)
+    {
+        h = nibble_hash::fnv1a64(data, size, h);
+    }
+};
+
+} // namespace nibble_cache_detail
+
+inline FileStat FileStat::of(const std::string& path)
+{
+    FileStat st;
+
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat sb;
+    if (::stat(path.c_str(), &sb) != 0) {
+        throw std::runtime_error("Cannot stat file: " + path);
+    }
+    st.dev  = static_cast<std::uint64_t>(sb.st_dev);
+    st.ino  = static_cast<std::uint64_t>(sb.st_ino);
+    st.size = static_cast<std::uint64_t>(sb.st_size);
+#if defined(__APPLE__)
+    st.mtime_ns = static_cast<std::int64_t>(sb.st_mtimespec.tv_sec) * 1000000000 + sb.st_mtimespec.tv_nsec;
+    st.ctime_ns = static_cast<std::int64_t>(sb.st_ctimespec.tv_sec) * 1000000000 + sb.st_ctimespec.tv_nsec;
+#else
+    st.mtime_ns = static_cast<std::int64_t>(sb.st_mtim.tv_sec) * 1000000000 + sb.st_mtim.tv_nsec;
+    st.ctime_ns = static_cast<std::int64_t>(sb.st_ctim.tv_sec) * 1000000000 + sb.st_ctim.tv_nsec;
+#endif
+#else
+    // Без POSIX: идентичность — каноничный путь, ctime недоступен
+    namespace fs = std::filesystem;
+    const fs::path p = fs::u8path(path);
+    std::error_code ec;
+    const std::string canonical = fs::canonical(p, ec).u8string();
+    if (ec) {
+        throw std::runtime_error("Cannot stat file: " + path);
+    }
+    st.ino      = nibble_hash::fnv1a64(canonical.data(), canonical.size());
+    st.size     = fs::file_size(p);
+    st.mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      fs::last_write_time(p).time_since_epoch()).count();
+#endif
+
+    return st;
+}
+
+inline std::uint64_t ResultCache::file_key(const FileStat& stat)
+{
+    std::uint64_t h = nibble_hash::fnv1a64(&stat.dev, sizeof(stat.dev));
+    return nibble_hash::fnv1a64(&stat.ino, sizeof(stat.ino), h);
+}
+
+inline std::uint64_t ResultCache::full_hash(const std::string& path, std::uint64_t length)
+{
+    // Хэшируем ровно length байт: файл мог дорасти после анализа
+    struct Limited
+    {
+        nibble_cache_detail::HashSink sink;
+        std::uint64_t                 left;
+
+        void feed(const std::uint8_t* data, std::size_t size)
+        {
+            const std::size_t take = static_cast<std::size_t>(std::min<std::uint64_t>(left, size));
+            sink.feed(data, take);
+            left -= take;
+        }
+    } limited{ {}, length };
+
+    nibble_io::feed_file(path, limited);
+    return limited.sink.h;
+}
+
+inline std::filesystem::path ResultCache::entry_path(std::uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx%s",
+                  static_cast<unsigned long long>(key), nibble_cache_detail::ENTRY_SUFFIX);
+    return m_dir / name;
+}
+
+// Формат записи (little-endian): "NBLCACHE", u64 версия, u64 ключ,
+// FileStat (u64 dev, ino, size, mtime_ns, ctime_ns), u64 полный хэш
+// (0 — без проверки), u64 отпечаток префикса, Segmenter::save;
+// в конце u64 FNV-1a всего предыдущего.
+inline void ResultCache::store(const std::string& path, const CachedResult& result) const
+{
+    namespace fs = std::filesystem;
+    using nibble_io::put_u64;
+
+    const std::uint64_t length = result.segmenter.processed();
+    const std::uint64_t key    = file_key(result.stat);
+
+    std::ostringstream out(std::ios::binary);
+    out.write(nibble_cache_detail::MAGIC, 8);
+    put_u64(out, nibble_cache_detail::VERSION);
+    put_u64(out, key);
+    put_u64(out, result.stat.dev);
+    put_u64(out, result.stat.ino);
+    put_u64(out, result.stat.size);
+    put_u64(out, static_cast<std::uint64_t>(result.stat.mtime_ns));
+    put_u64(out, static_cast<std::uint64_t>(result.stat.ctime_ns));
+    put_u64(out, m_verify ? full_hash(path, length) : 0);
+    put_u64(out, result.fingerprint);
+    result.segmenter.save(out);
+    std::string bytes = out.str();
+    const std::uint64_t sum = nibble_hash::fnv1a64(bytes.data(), bytes.size());
+    {
+        std::ostringstream tail(std::ios::binary);
+        put_u64(tail, sum);
+        bytes += tail.str();
+    }
+
+    std::error_code ec;
+    fs::create_directories(m_dir, ec);
+
+    // Уникальное временное имя: другие экземпляры пишут в тот же каталог
+    const std::uint64_t salt = (static_cast<std::uint64_t>(std::random_device{}()) << 32)
+                             ^ std::hash<std::thread::id>{}(std::this_thread::get_id());
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%016llx.tmp", static_cast<unsigned long long>(salt));
+    const fs::path target = entry_path(key);
+    fs::path tmp = target;
+    tmp += suffix;
+
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            throw std::runtime_error("Cannot open file for writing: " + tmp.u8string());
+        }
+        f.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!f) {
+            f.close();
+            fs::remove(tmp, ec);
+            throw std::runtime_error("Failed to write all data to file: " + tmp.u8string());
+        }
+    }
+
+    fs::rename(tmp, target, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return; // запись другого экземпляра тоже годится
+    }
+
+    evict();
+}
+
+inline std::optional<CachedResult> ResultCache::find(const std::string& path) const
+{
+    namespace fs = std::filesystem;
+    using nibble_io::get_u64;
+
+    const FileStat      current = FileStat::of(path);
+    const std::uint64_t key     = file_key(current);
+    const fs::path      entry   = entry_path(key);
+
+    std::string bytes;
+    {
+        std::ifstream f(entry, std::ios::binary);
+        if (!f) {
+            return std::nullopt;
+        }
+        std::ostringstream ss;
+        ss << f.rdbuf();
+        bytes = ss.str();
+    }
+
+    // Битая или чужая запись — просто промах
+    if (bytes.size() < 8 + 8 * 11) {
+        return std::nullopt;
+    }
+    std::istringstream sum_in(bytes.substr(bytes.size() - 8), std::ios::binary);
+    if (get_u64(sum_in) != nibble_hash::fnv1a64(bytes.data(), bytes.size() - 8)) {
+        return std::nullopt;
+    }
+
+    std::istringstream in(bytes, std::ios::binary);
+    char magic[8] = {};
+    in.read(magic, 8);
+    if (!std::equal(magic, magic + 8, nibble_cache_detail::MAGIC)
+        || get_u64(in) != nibble_cache_detail::VERSION
+        || get_u64(in) != key) {
+        return std::nullopt;
+    }
+
+    CachedResult result;
+    result.stat.dev      = get_u64(in);
+    result.stat.ino      = get_u64(in);
+    result.stat.size     = get_u64(in);
+    result.stat.mtime_ns = static_cast<std::int64_t>(get_u64(in));
+    result.stat.ctime_ns = static_cast<std::int64_t>(get_u64(in));
+    const std::uint64_t hash = get_u64(in);
+    result.fingerprint   = get_u64(in);
+    try {
+        result.segmenter = nibble_segmentation::Segmenter::load(in);
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+
+    // Не менялся: те же метаданные, и анализ покрыл файл целиком.
+    // Вырос: тот же файл длиннее обработанного — дочитает update().
+    const std::uint64_t processed = result.segmenter.processed();
+    const bool unchanged = current == result.stat && current.size == processed;
+    const bool grown     = current.same_file(result.stat) && current.size > processed;
+    if (!unchanged && !grown) {
+        return std::nullopt;
+    }
+
+    // Запись, сделанная без проверки, хэша не содержит — ей не доверяем
+    if (m_verify && (hash == 0 || full_hash(path, processed) != hash)) {
+        return std::nullopt;
+    }
+
+    // LRU: отметка об использовании
+    std::error_code ec;
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+
+    return result;
+}
+
+inline void ResultCache::evict() const
+{
+    namespace fs = std::filesystem;
+
+    struct Item
+    {
+        fs::path            path;
+        std::uint64_t       size;
+        fs::file_time_type  time;
+    };
+
+    // Другие экземпляры могут параллельно удалять файлы — ошибки игнорируем
+    std::error_code ec;
+    std::vector<Item> items;
+    std::uint64_t total = 0;
+    const auto now = fs::file_time_type::clock::now();
+    for (fs::directory_iterator it(m_dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code ec2;
+        const fs::path p = it->path();
+        const auto time = fs::last_write_time(p, ec2);
+        if (ec2) continue;
+
+        // Брошенные временные файлы (упавший экземпляр) старше часа
+        if (p.extension() == ".tmp") {
+            if (now - time > std::chrono::hours(1)) fs::remove(p, ec2);
+            continue;
+        }
+        if (p.extension() != nibble_cache_detail::ENTRY_SUFFIX) continue;
+
+        const std::uint64_t size = fs::file_size(p, ec2);
+        if (ec2) continue;
+        items.push_back({ p, size, time });
+        total += size;
+    }
+
+    if (total <= m_max_bytes) {
+        return;
+    }
+
+    std::sort(items.begin(), items.end(),
+              [](const Item& a, const Item& b) { return a.time < b.time; });
+    for (const auto& item : items) {
+        if (total <= m_max_bytes) break;
+        std::error_code ec2;
+        if (fs::remove(item.path, ec2)) {
+            total -= item.size;
+        }
+    }
+}
+
+#endif // NIBBLE_CACHE_H
@@ -0,0 +1,769 @@
+#pragma once
+#ifndef NIBBLE_CONTAINER_H
+#define NIBBLE_CONTAINER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "nibble_hash.h"
+#include "nibbles_io.h"
+
+// Контейнер .nibbles: много файлов в одном архиве.
+//
+// Формат (все целые — little-endian):
+//   [заголовок]  "NBLCONT\0", u32 версия, u32 резерв
+//   [данные]     члены подряд, каждый своим методом (NibbleContainerMethod)
+//   [индекс]     на каждый член: u32 длина имени, имя (UTF-8, '/'),
+//                u64 размер, u64 смещение, u64 размер в архиве, u64 FNV-1a,
+//                u32 метод
+//   [хвост]      u64 смещение индекса, u64 число членов, u64 FNV-1a индекса,
+//                "NBLINDEX"
+//
+// Метод Markov — адаптивный двоичный range coder по нибблам с контекстом из
+// предыдущего ниббла: размер члена близок к N * H(S_{i+1} | S_i) бит. Если так
+// не получается меньше исходного, член хранится как есть (Stored).
+//
+// Индекс лежит в конце, поэтому список и извлечение одного члена читают только
+// хвост, индекс и нужный кусок данных.
+
+enum class NibbleContainerMethod : std::uint32_t
+{
+    Stored = 0, // байты как есть
+    Markov = 1  // range coder с моделью переходов нибблов
+};
+
+struct NibbleContainerEntry
+{
+    std::string           name;            // относительный путь внутри контейнера
+    std::uint64_t         size        = 0; // исходный размер, байт
+    std::uint64_t         offset      = 0; // смещение упакованных данных в архиве
+    std::uint64_t         packed_size = 0; // размер упакованных данных
+    std::uint64_t         checksum    = 0; // FNV-1a исходных байтов
+    NibbleContainerMethod method      = NibbleContainerMethod::Stored;
+};
+
+class NibbleContainerArchiever
+{
+public:
+    // threads == 0 — по числу ядер
+    explicit NibbleContainerArchiever(unsigned threads = 0)
+        : m_threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency()))
+    {}
+
+    // Упаковать набор файлов: пары (путь на диске, имя внутри контейнера).
+    // Имена должны быть уникальны, сам архив среди файлов быть не может.
+    void pack(const std::vector<std::pair<std::string, std::string>>& files,
+              const std::string& path);
+    // Упаковать все обычные файлы каталога рекурсивно
+    void pack_directory(const std::string& dir, const std::string& path);
+
+    // Добавить в files все обычные файлы каталога dir рекурсивно с именами
+    // prefix + путь относительно dir; файл архива path пропускается
+    static void collect_directory(const std::string& dir, const std::string& prefix,
+                                  const std::string& path,
+                                  std::vector<std::pair<std::string, std::string>>& files);
+
+    // Члены в порядке индекса; индекс с повторяющимися именами отвергается
+    std::vector<NibbleContainerEntry> list(const std::string& path);
+
+    // Извлечь один член, не декодируя остальные
+    std::vector<std::uint8_t> extract(const std::string& path, const NibbleContainerEntry& entry);
+    void extract_to(const std::string& path, const std::string& name, const std::string& target);
+    void extract_to(const std::string& path, const NibbleContainerEntry& entry, const std::string& target);
+    // Извлечь всё в каталог dir (параллельно)
+    void unpack_all(const std::string& path, const std::string& dir);
+
+    // Range coder с моделью переходов нибблов и обратно
+    static std::vector<std::uint8_t> encode_markov(const std::uint8_t* data, std::size_t size);
+    static std::vector<std::uint8_t> decode_markov(const std::uint8_t* packed, std::size_t packed_size,
+                                                   std::uint64_t size);
+
+    // Относительный путь без "..", пустых частей и имени диска: такой член
+    // можно извлечь внутрь каталога, не выходя за его пределы
+    static bool is_safe_name(const std::string& name);
+
+private:
+    static void put_u32(std::vector<std::uint8_t>& out, std::uint32_t v);
+    static void put_u64(std::vector<std::uint8_t>& out, std::uint64_t v);
+    static std::uint64_t get_u64(const std::uint8_t* p);
+    static std::uint32_t get_u32(const std::uint8_t* p);
+
+    // Запустить fn(i) для i в [0, count) на m_threads потоках
+    template <class Fn>
+    void parallel_for(std::size_t count, Fn&& fn);
+
+    unsigned m_threads;
+};
+
+namespace nibble_container_detail
+{
+
+const char          MAGIC[8]       = { 'N', 'B', 'L', 'C', 'O', 'N', 'T', '\0' };
+const char          INDEX_MAGIC[8] = { 'N', 'B', 'L', 'I', 'N', 'D', 'E', 'X' };
+const std::uint32_t VERSION        = 1;
+const std::size_t   HEADER_SIZE    = 16;
+const std::size_t   FOOTER_SIZE    = 32;
+
+// Range coder: вероятности нуля в 1/2^PROB_BITS, адаптация со сдвигом MOVE_BITS
+const unsigned      PROB_BITS      = 11;
+const unsigned      MOVE_BITS      = 5;
+const std::uint32_t PROB_INIT      = 1u << (PROB_BITS - 1);
+const std::uint32_t RANGE_TOP      = 1u << 24;
+
+// Вероятность не выходит за [31, 2017] / 2048, поэтому решение стоит не меньше
+// 0.022 бита, а байт (8 решений) — не меньше 0.17 бита: из packed_size байт
+// получается не больше ~46 * packed_size исходных. Больший размер в индексе —
+// повреждение, и память под него не выделяем.
+const std::uint64_t MAX_MARKOV_RATIO = 64;
+
+// Модель: для каждого предыдущего ниббла — двоичное дерево из 15 узлов
+// (старший бит первым)
+using MarkovModel = std::array<std::array<std::uint16_t, 16>, 16>;
+
+inline MarkovModel markov_model()
+{
+    MarkovModel m;
+    for (auto& ctx : m) ctx.fill(static_cast<std::uint16_t>(PROB_INIT));
+    return m;
+}
+
+class RangeEncoder
+{
+public:
+    explicit RangeEncoder(std::vector<std::uint8_t>& out) : m_out(out) {}
+
+    void encode(std::uint16_t& p, unsigned bit)
+    {
+        const std::uint32_t bound = (m_range >> PROB_BITS) * p;
+        if (!bit) {
+            m_range = bound;
+            p = static_cast<std::uint16_t>(p + (((1u << PROB_BITS) - p) >> MOVE_BITS));
+        } else {
+            m_low   += bound;
+            m_range -= bound;
+            p = static_cast<std::uint16_t>(p - (p >> MOVE_BITS));
+        }
+        while (m_range < RANGE_TOP) {
+            m_range <<= 8;
+            shift_low();
+        }
+    }
+
+    void flush()
+    {
+        for (int i = 0; i < 5; ++i) shift_low();
+    }
+
+private:
+    // Выталкиваем старший байт low; перенос дописывается в отложенные 0xFF
+    void shift_low()
+    {
+        if (static_cast<std::uint32_t>(m_low) < 0xFF000000u || (m_low >> 32) != 0) {
+            const std::uint8_t carry = static_cast<std::uint8_t>(m_low >> 32);
+            std::uint8_t temp = m_cache;
+            do {
+                m_out.push_back(static_cast<std::uint8_t>(temp + carry));
+                temp = 0xFF;
+            } while (--m_cache_size != 0);
+            m_cache = static_cast<std::uint8_t>(m_low >> 24);
+        }
+        ++m_cache_size;
+        m_low = (m_low & 0x00FFFFFFu) << 8;
+    }
+
+    std::vector<std::uint8_t>& m_out;
+    std::uint64_t              m_low{0};
+    std::uint32_t              m_range{0xFFFFFFFFu};
+    std::uint8_t               m_cache{0};
+    std::uint64_t              m_cache_size{1};
+};
+
+class RangeDecoder
+{
+public:
+    RangeDecoder(const std::uint8_t* data, std::size_t size) : m_data(data), m_size(size)
+    {
+        for (int i = 0; i < 5; ++i) m_code = (m_code << 8) | next();
+    }
+
+    unsigned decode(std::uint16_t& p)
+    {
+        const std::uint32_t bound = (m_range >> PROB_BITS) * p;
+        unsigned bit;
+        if (m_code < bound) {
+            m_range = bound;
+            p = static_cast<std::uint16_t>(p + (((1u << PROB_BITS) - p) >> MOVE_BITS));
+            bit = 0;
+        } else {
+            m_code  -= bound;
+            m_range -= bound;
+            p = static_cast<std::uint16_t>(p - (p >> MOVE_BITS));
+            bit = 1;
+        }
+        while (m_range < RANGE_TOP) {
+            m_range <<= 8;
+            m_code = (m_code << 8) | next();
+        }
+        return bit;
+    }
+
+    std::size_t consumed() const { return m_pos; }
+
+private:
+    std::uint32_t next()
+    {
+        if (m_pos >= m_size) {
+            throw std::runtime_error("Truncated member data in container");
+        }
+        return m_data[m_pos++];
+    }
+
+    const std::uint8_t* m_data;
+    std::size_t         m_size;
+    std::size_t         m_pos{0};
+    std::uint32_t       m_code{0};
+    std::uint32_t       m_range{0xFFFFFFFFu};
+};
+
+} // namespace nibble_container_detail
+
+inline void NibbleContainerArchiever::put_u32(std::vector<std::uint8_t>& out, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+}
+
+inline void NibbleContainerArchiever::put_u64(std::vector<std::uint8_t>& out, std::uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+}
+
+inline std::uint32_t NibbleContainerArchiever::get_u32(const std::uint8_t* p)
+{
+    std::uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+inline std::uint64_t NibbleContainerArchiever::get_u64(const std::uint8_t* p)
+{
+    std::uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+inline bool NibbleContainerArchiever::is_safe_name(const std::string& name)
+{
+    // Только относительные пути без ".." — иначе извлечение выйдет за каталог
+    if (name.empty() || name.front() == '/' || name.front() == '\\') return false;
+    if (name.find(':') != std::string::npos) return false;
+
+    std::size_t start = 0;
+    while (start <= name.size()) {
+        std::size_t end = name.find_first_of("/\\", start);
+        if (end == std::string::npos) end = name.size();
+        const std::string part = name.substr(start, end - start);
+        if (part.empty() || part == "." || part == "..") return false;
+        start = end + 1;
+    }
+    return true;
+}
+
+inline std::vector<std::uint8_t> NibbleContainerArchiever::encode_markov(const std::uint8_t* data,
+                                                                         std::size_t size)
+{
+    using namespace nibble_container_detail;
+
+    std::vector<std::uint8_t> out;
+    out.reserve(size / 2 + 16);
+
+    MarkovModel model = markov_model();
+    RangeEncoder rc(out);
+    unsigned prev = 0;
+    auto put = [&](unsigned n) {
+        auto& tree = model[prev];
+        unsigned node = 1;
+        for (int b = 3; b >= 0; --b) {
+            const unsigned bit = (n >> b) & 1u;
+            rc.encode(tree[node], bit);
+            node = (node << 1) | bit;
+        }
+        prev = n;
+    };
+
+    for (std::size_t i = 0; i < size; ++i) {
+        put((data[i] >> 4) & 0x0Fu);
+        put(data[i] & 0x0Fu);
+    }
+    rc.flush();
+
+    return out;
+}
+
+inline std::vector<std::uint8_t> NibbleContainerArchiever::decode_markov(const std::uint8_t* packed,
+                                                                         std::size_t packed_size,
+                                                                         std::uint64_t size)
+{
+    using namespace nibble_container_detail;
+
+    // Размер берётся из индекса: проверяем до выделения памяти
+    if (size / MAX_MARKOV_RATIO > packed_size) {
+        throw std::runtime_error("Invalid member size in container");
+    }
+
+    std::vector<std::uint8_t> out(static_cast<std::size_t>(size));
+
+    MarkovModel model = markov_model();
+    RangeDecoder rc(packed, packed_size);
+    unsigned prev = 0;
+    auto get = [&]() {
+        auto& tree = model[prev];
+        unsigned node = 1;
+        for (int b = 0; b < 4; ++b) {
+            node = (node << 1) | rc.decode(tree[node]);
+        }
+        prev = node - 16;
+        return prev;
+    };
+
+    for (auto& byte : out) {
+        const unsigned hi = get();
+        byte = static_cast<std::uint8_t>((hi << 4) | get());
+    }
+
+    if (rc.consumed() != packed_size) {
+        throw std::runtime_error("Trailing data in container member");
+    }
+
+    return out;
+}
+
+template <class Fn>
+void NibbleContainerArchiever::parallel_for(std::size_t count, Fn&& fn)
+{
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+        while (true) {
+            const std::size_t i = next.fetch_add(1);
+            if (i >= count) return;
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+                next.store(count); // остальным больше не брать работу
+            }
+        }
+    };
+
+    const std::size_t n = std::min<std::size_t>(m_threads, count);
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < n; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    if (error) std::rethrow_exception(error);
+}
+
+inline void NibbleContainerArchiever::pack(const std::vector<std::pair<std::string, std::string>>& files,
+                                           const std::string& path)
+{
+    using namespace nibble_container_detail;
+
+    // Проверяем до того, как обрезать файл архива
+    std::error_code ec;
+    const std::filesystem::path self = std::filesystem::weakly_canonical(std::filesystem::u8path(path), ec);
+
+    std::set<std::string> names;
+    for (const auto& f : files) {
+        if (!is_safe_name(f.second)) {
+            throw std::runtime_error("Invalid member name: " + f.second);
+        }
+        if (!names.insert(f.second).second) {
+            throw std::runtime_error("Duplicate member name: " + f.second);
+        }
+        if (!self.empty() && std::filesystem::weakly_canonical(std::filesystem::u8path(f.first), ec) == self) {
+            throw std::runtime_error("Cannot pack the container into itself: " + f.first);
+        }
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open file for writing: " + path);
+    }
+
+    std::vector<std::uint8_t> header(MAGIC, MAGIC + 8);
+    put_u32(header, VERSION);
+    put_u32(header, 0);
+    out.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+
+    // Члены сжимаются параллельно, а пишутся строго по порядку.
+    // Окно ограничивает, насколько потоки могут уйти вперёд записи.
+    struct Packed
+    {
+        bool                      ready = false;
+        std::uint64_t             size = 0;
+        std::uint64_t             checksum = 0;
+        NibbleContainerMethod     method = NibbleContainerMethod::Stored;
+        std::vector<std::uint8_t> data;
+    };
+
+    const std::size_t count  = files.size();
+    const std::size_t window = 4 * static_cast<std::size_t>(m_threads);
+    std::vector<Packed> packed(count);
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t written = 0;
+    bool failed = false;
+
+    std::vector<NibbleContainerEntry> entries(count);
+    std::uint64_t offset = HEADER_SIZE;
+
+    // Буферы чтения переходят от члена к члену (не больше одного на поток),
+    // так что файл читается без нового выделения, если влезает в прежний
+    std::vector<std::vector<std::uint8_t>> buffers;
+
+    std::exception_ptr writer_error;
+    std::thread writer([&]() {
+        try {
+            for (std::size_t i = 0; i < count; ++i) {
+                std::vector<std::uint8_t> data;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&] { return packed[i].ready || failed; });
+                    if (failed) return;
+                    data.swap(packed[i].data);
+                    entries[i].size     = packed[i].size;
+                    entries[i].checksum = packed[i].checksum;
+                    entries[i].method   = packed[i].method;
+                }
+
+                entries[i].name        = files[i].second;
+                entries[i].offset      = offset;
+                entries[i].packed_size = data.size();
+                out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+                if (!out) {
+                    throw std::runtime_error("Failed to write all data to file: " + path);
+                }
+                offset += data.size();
+
+                std::lock_guard<std::mutex> lock(mutex);
+                written = i + 1;
+                cv.notify_all();
+            }
+        } catch (...) {
+            writer_error = std::current_exception();
+            std::lock_guard<std::mutex> lock(mutex);
+            failed = true;
+            cv.notify_all();
+        }
+    });
+
+    try {
+        parallel_for(count, [&](std::size_t i) {
+            std::vector<std::uint8_t> bytes;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return i < written + window || failed; });
+                if (failed) return;
+                if (!buffers.empty()) {
+                    bytes.swap(buffers.back());
+                    buffers.pop_back();
+                }
+            }
+
+            Packed p;
+            try {
+                nibble_io::read_to_bin(files[i].first, bytes);
+                p.size     = bytes.size();
+                p.checksum = nibble_hash::fnv1a64(bytes.data(), bytes.size());
+                p.data     = encode_markov(bytes.data(), bytes.size());
+                p.method   = NibbleContainerMethod::Markov;
+                if (p.data.size() >= bytes.size()) {
+                    // Несжимаемые данные (уже сжатые, шифрованные) — как есть;
+                    // буфер уходит в член и в пул не возвращается
+                    p.data   = std::move(bytes);
+                    p.method = NibbleContainerMethod::Stored;
+                }
+                p.ready    = true;
+            } catch (...) {
+                // Будим писателя и потоки, ждущие окна, иначе они не дождутся члена i
+                std::lock_guard<std::mutex> lock(mutex);
+                failed = true;
+                cv.notify_all();
+                throw;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (p.method == NibbleContainerMethod::Markov) {
+                buffers.push_back(std::move(bytes));
+            }
+            packed[i] = std::move(p);
+            cv.notify_all();
+        });
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            failed = true;
+            cv.notify_all();
+        }
+        writer.join();
+        throw;
+    }
+
+    writer.join();
+    if (writer_error) std::rethrow_exception(writer_error);
+
+    // Индекс и хвост
+    std::vector<std::uint8_t> index;
+    for (const auto& e : entries) {
+        put_u32(index, static_cast<std::uint32_t>(e.name.size()));
+        index.insert(index.end(), e.name.begin(), e.name.end());
+        put_u64(index, e.size);
+        put_u64(index, e.offset);
+        put_u64(index, e.packed_size);
+        put_u64(index, e.checksum);
+        put_u32(index, static_cast<std::uint32_t>(e.method));
+    }
+
+    std::vector<std::uint8_t> footer;
+    put_u64(footer, offset);
+    put_u64(footer, static_cast<std::uint64_t>(count));
+    put_u64(footer, nibble_hash::fnv1a64(index.data(), index.size()));
+    footer.insert(footer.end(), INDEX_MAGIC, INDEX_MAGIC + 8);
+
+    out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+    out.write(reinterpret_cast<const char*>(footer.data()), static_cast<std::streamsize>(footer.size()));
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Failed to write all data to file: " + path);
+    }
+}
+
+inline void NibbleContainerArchiever::collect_directory(const std::string& dir,
+                                                        const std::string& prefix,
+                                                        const std::string& path,
+                                                        std::vector<std::pair<std::string, std::string>>& files)
+{
+    namespace fs = std::filesystem;
+
+    const fs::path root = fs::u8path(dir);
+    if (!fs::is_directory(root)) {
+        throw std::runtime_error("Not a directory: " + dir);
+    }
+
+    // Сам архив может лежать внутри упаковываемого каталога — пропускаем его
+    std::error_code ec;
+    const fs::path self = fs::weakly_canonical(fs::u8path(path), ec);
+
+    for (const auto& it : fs::recursive_directory_iterator(root)) {
+        if (!it.is_regular_file()) continue;
+        if (!self.empty() && fs::weakly_canonical(it.path(), ec) == self) continue;
+
+        files.emplace_back(it.path().u8string(),
+                           prefix + it.path().lexically_relative(root).generic_u8string());
+    }
+}
+
+inline void NibbleContainerArchiever::pack_directory(const std::string& dir, const std::string& path)
+{
+    std::vector<std::pair<std::string, std::string>> files;
+    collect_directory(dir, std::string(), path, files);
+
+    // Стабильный порядок членов независимо от файловой системы
+    std::sort(files.begin(), files.end(),
+              [](const auto& a, const auto& b) { return a.second < b.second; });
+
+    pack(files, path);
+}
+
+inline std::vector<NibbleContainerEntry> NibbleContainerArchiever::list(const std::string& path)
+{
+    using namespace nibble_container_detail;
+
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+        throw std::runtime_error("Cannot open file for reading: " + path);
+    }
+
+    f.seekg(0, std::ios::end);
+    const std::streampos sz = f.tellg();
+    if (sz < static_cast<std::streampos>(HEADER_SIZE + FOOTER_SIZE)) {
+        throw std::runtime_error("Not a nibble container: " + path);
+    }
+    const std::uint64_t file_size = static_cast<std::uint64_t>(sz);
+
+    std::array<std::uint8_t, HEADER_SIZE> header{};
+    f.seekg(0, std::ios::beg);
+    f.read(reinterpret_cast<char*>(header.data()), HEADER_SIZE);
+    if (!f || !std::equal(MAGIC, MAGIC + 8, header.begin())) {
+        throw std::runtime_error("Not a nibble container: " + path);
+    }
+    const std::uint32_t version = get_u32(header.data() + 8);
+    if (version != VERSION) {
+        throw std::runtime_error("Unsupported container version: " + path);
+    }
+
+    std::array<std::uint8_t, FOOTER_SIZE> footer{};
+    f.seekg(static_cast<std::streamoff>(file_size - FOOTER_SIZE), std::ios::beg);
+    f.read(reinterpret_cast<char*>(footer.data()), FOOTER_SIZE);
+    if (!f || !std::equal(INDEX_MAGIC, INDEX_MAGIC + 8, footer.begin() + 24)) {
+        throw std::runtime_error("Container index is missing: " + path);
+    }
+
+    const std::uint64_t index_offset = get_u64(footer.data());
+    const std::uint64_t count        = get_u64(footer.data() + 8);
+    const std::uint64_t index_sum    = get_u64(footer.data() + 16);
+    if (index_offset < HEADER_SIZE || index_offset > file_size - FOOTER_SIZE) {
+        throw std::runtime_error("Corrupted container index: " + path);
+    }
+
+    std::vector<std::uint8_t> index(static_cast<std::size_t>(file_size - FOOTER_SIZE - index_offset));
+    f.seekg(static_cast<std::streamoff>(index_offset), std::ios::beg);
+    f.read(reinterpret_cast<char*>(index.data()), static_cast<std::streamsize>(index.size()));
+    if (f.gcount() != static_cast<std::streamsize>(index.size())
+        || nibble_hash::fnv1a64(index.data(), index.size()) != index_sum) {
+        throw std::runtime_error("Corrupted container index: " + path);
+    }
+
+    std::vector<NibbleContainerEntry> entries;
+    std::set<std::string> names;
+    std::size_t pos = 0;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (index.size() - pos < 4) {
+            throw std::runtime_error("Corrupted container index: " + path);
+        }
+        const std::uint32_t name_len = get_u32(index.data() + pos);
+        pos += 4;
+        if (index.size() - pos < static_cast<std::size_t>(name_len) + 36) {
+            throw std::runtime_error("Corrupted container index: " + path);
+        }
+
+        NibbleContainerEntry e;
+        e.name.assign(reinterpret_cast<const char*>(index.data() + pos), name_len);
+        pos += name_len;
+        e.size        = get_u64(index.data() + pos);
+        e.offset      = get_u64(index.data() + pos + 8);
+        e.packed_size = get_u64(index.data() + pos + 16);
+        e.checksum    = get_u64(index.data() + pos + 24);
+        const std::uint32_t method = get_u32(index.data() + pos + 32);
+        if (method > static_cast<std::uint32_t>(NibbleContainerMethod::Markov)) {
+            throw std::runtime_error("Unsupported member method in container: " + path);
+        }
+        e.method      = static_cast<NibbleContainerMethod>(method);
+        pos += 36;
+
+        if (e.offset < HEADER_SIZE || e.offset > index_offset
+            || e.packed_size > index_offset - e.offset) {
+            throw std::runtime_error("Corrupted container index: " + path);
+        }
+        // Два члена с одним именем при распаковке писали бы в один файл
+        if (!names.insert(e.name).second) {
+            throw std::runtime_error("Duplicate member name in container: " + e.name);
+        }
+        entries.push_back(std::move(e));
+    }
+
+    return entries;
+}
+
+inline std::vector<std::uint8_t> NibbleContainerArchiever::extract(const std::string& path,
+                                                                   const NibbleContainerEntry& entry)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+        throw std::runtime_error("Cannot open file for reading: " + path);
+    }
+
+    if (entry.method == NibbleContainerMethod::Stored && entry.packed_size != entry.size) {
+        throw std::runtime_error("Invalid member size in container");
+    }
+
+    std::vector<std::uint8_t> packed(static_cast<std::size_t>(entry.packed_size));
+    f.seekg(static_cast<std::streamoff>(entry.offset), std::ios::beg);
+    f.read(reinterpret_cast<char*>(packed.data()), static_cast<std::streamsize>(packed.size()));
+    if (f.gcount() != static_cast<std::streamsize>(packed.size())) {
+        throw std::runtime_error("Failed to read member " + entry.name + " from " + path);
+    }
+
+    std::vector<std::uint8_t> bytes;
+    switch (entry.method) {
+    case NibbleContainerMethod::Stored:
+        bytes = std::move(packed);
+        break;
+    case NibbleContainerMethod::Markov:
+        bytes = decode_markov(packed.data(), packed.size(), entry.size);
+        break;
+    }
+    if (nibble_hash::fnv1a64(bytes.data(), bytes.size()) != entry.checksum) {
+        throw std::runtime_error("Checksum mismatch for member: " + entry.name);
+    }
+
+    return bytes;
+}
+
+inline void NibbleContainerArchiever::extract_to(const std::string& path,
+                                                 const std::string& name,
+                                                 const std::string& target)
+{
+    for (const auto& e : list(path)) {
+        if (e.name == name) {
+            extract_to(path, e, target);
+            return;
+        }
+    }
+
+    throw std::runtime_error("No such member in container: " + name);
+}
+
+inline void NibbleContainerArchiever::extract_to(const std::string& path,
+                                                 const NibbleContainerEntry& entry,
+                                                 const std::string& target)
+{
+    const std::vector<std::uint8_t> bytes = extract(path, entry);
+    std::ofstream out(target, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open file for writing: " + target);
+    }
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+        throw std::runtime_error("Failed to write all data to file: " + target);
+    }
+}
+
+inline void NibbleContainerArchiever::unpack_all(const std::string& path, const std::string& dir)
+{
+    namespace fs = std::filesystem;
+
+    const std::vector<NibbleContainerEntry> entries = list(path);
+    for (const auto& e : entries) {
+        if (!is_safe_name(e.name)) {
+            throw std::runtime_error("Invalid member name: " + e.name);
+        }
+    }
+
+    const fs::path root = fs::u8path(dir);
+    parallel_for(entries.size(), [&](std::size_t i) {
+        const fs::path target = root / fs::u8path(entries[i].name);
+        fs::create_directories(target.parent_path());
+        extract_to(path, entries[i], target.u8string());
+    });
+}
+
+#endif // NIBBLE_CONTAINER_H
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef NIBBLE_HASH_H
+#define NIBBLE_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nibble_hash
+{
+
+const std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+const std::uint64_t FNV_PRIME        = 0x100000001b3ull;
+
+// FNV-1a 64: быстрая некриптографическая контрольная сумма.
+// seed позволяет продолжить хэш по следующему куску данных.
+inline std::uint64_t fnv1a64(const void* data, std::size_t size,
+                             std::uint64_t seed = FNV_OFFSET_BASIS)
+{
+    const auto* p = static_cast<const std::uint8_t*>(data);
+    std::uint64_t h = seed;
+    for (std::size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+} // namespace nibble_hash
+
+#endif // NIBBLE_HASH_H
@@ -0,0 +1,120 @@
+#pragma once
+#ifndef NIBBLE_INCREMENTAL_H
+#define NIBBLE_INCREMENTAL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "nibble_hash.h"
+#include "nibbles_io.h"
+
+// Дозапись вместо пересчёта для растущих файлов (логи, захваты трафика).
+//
+// Состояние — приёмник (счётчики, последний ниббл, число обработанных
+// байтов) и отпечаток уже обработанного префикса. При повторном анализе, если
+// файл не короче и отпечаток префикса совпал, читаются только добавленные байты.
+//
+// Чтобы продолжить после перезагрузки, приёмник сохраняют сам (например,
+// Segmenter::save/load) вместе с отпечатком.
+namespace nibble_incremental
+{
+
+// Сколько байтов в начале и в конце префикса попадает в отпечаток
+const std::size_t FINGERPRINT_WINDOW = 64 * 1024;
+
+inline std::uint64_t file_size(const std::string& path)
+{
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    if (!f) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    const std::streampos sz = f.tellg();
+    if (sz < std::streampos{0}) {
+        throw std::runtime_error("Cannot determine file size: " + path);
+    }
+    return static_cast<std::uint64_t>(sz);
+}
+
+// Отпечаток префикса [0, length): длина + первые и последние
+// FINGERPRINT_WINDOW байт. Читать весь префикс заново — ровно то, чего
+// мы избегаем, поэтому перезапись середины файла не обнаруживается.
+inline std::uint64_t prefix_fingerprint(const std::string& path, std::uint64_t length)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+
+    std::uint64_t h = nibble_hash::fnv1a64(&length, sizeof(length));
+
+    std::vector<std::uint8_t> buf(FINGERPRINT_WINDOW);
+    auto mix = [&](std::uint64_t off, std::size_t len) {
+        f.clear();
+        f.seekg(static_cast<std::streamoff>(off), std::ios::beg);
+        f.read(reinterpret_cast<char*>(buf.data()), static_cast<std::streamsize>(len));
+        if (f.gcount() != static_cast<std::streamsize>(len)) {
+            throw std::runtime_error("Failed to read file: " + path);
+        }
+        h = nibble_hash::fnv1a64(buf.data(), len, h);
+    };
+
+    const std::size_t head = static_cast<std::size_t>(std::min<std::uint64_t>(length, FINGERPRINT_WINDOW));
+    mix(0, head);
+    if (length > head) {
+        const std::size_t tail = static_cast<std::size_t>(std::min<std::uint64_t>(length - head, FINGERPRINT_WINDOW));
+        mix(length - tail, tail);
+    }
+
+    return h;
+}
+
+// Можно ли продолжить с processed: файл не укоротился и префикс тот же
+inline bool can_append(const std::string& path, std::uint64_t processed, std::uint64_t fingerprint)
+{
+    return file_size(path) >= processed && prefix_fingerprint(path, processed) == fingerprint;
+}
+
+enum class Update
+{
+    Unchanged,  // новых данных нет
+    Appended,   // дочитаны только добавленные байты
+    Rescanned,  // префикс изменился — пересчитано с нуля
+    Cancelled   // прервано через cancel; состояние нужно сбросить
+};
+
+// Довести приёмник до текущего содержимого файла. Sink — приёмник
+// nibble_io::feed_file_from с методом processed() (TransitionCounter,
+// nibble_segmentation::Segmenter); restart(sink) начинает подсчёт заново,
+// если префикс изменился. fingerprint — отпечаток обработанного префикса.
+template <class Sink, class Restart>
+inline Update update(const std::string& path, Sink& sink, std::uint64_t& fingerprint,
+                     Restart&& restart, const std::atomic<bool>* cancel = nullptr)
+{
+    const std::uint64_t before = sink.processed();
+
+    Update result = Update::Appended;
+    if (!can_append(path, before, fingerprint)) {
+        restart(sink);
+        result = Update::Rescanned;
+    }
+
+    if (!nibble_io::feed_file_from(path, sink.processed(), sink, cancel)) {
+        return Update::Cancelled;
+    }
+    fingerprint = prefix_fingerprint(path, sink.processed());
+
+    if (result == Update::Appended && sink.processed() == before) {
+        return Update::Unchanged;
+    }
+    return result;
+}
+
+} // namespace nibble_incremental
+
+#endif // NIBBLE_INCREMENTAL_H
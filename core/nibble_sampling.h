@@ -0,0 +1,414 @@
+#pragma once
+#ifndef NIBBLE_SAMPLING_H
+#define NIBBLE_SAMPLING_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "scheme.h"
+#include "transition_counter.h"
+
+// Быстрая выборочная оценка схемы переходов: вместо полного прохода по файлу
+// читаем стратифицированную случайную выборку блоков и оцениваем энтропии
+// с доверительными интервалами. Выборка удваивается, пока не достигнута
+// требуемая точность; Sampler позволяет делать раунды по одному (например,
+// первый — сразу, остальные — в фоновом потоке).
+namespace nibble_sampling
+{
+
+struct Options
+{
+    std::size_t   block_size     = 64 * 1024; // размер одного блока, байт
+    std::size_t   initial_blocks = 16;        // блоков в первом раунде
+    std::size_t   max_blocks     = 1024;      // потолок числа прочитанных блоков
+    double        precision      = 0.02;      // нужная полуширина интервала, бит
+    double        z              = 1.96;      // квантиль N(0,1): 1.96 ~ 95%
+    std::uint64_t seed           = 0x9E3779B97F4A7C15ull;
+};
+
+// Точечная оценка и доверительный интервал [low, high]
+struct Interval
+{
+    double value = 0.0;
+    double low   = 0.0;
+    double high  = 0.0;
+
+    double half_width() const { return (high - low) / 2.0; }
+};
+
+struct Estimate
+{
+    Scheme::Counts counts{};      // суммарные N_ab по прочитанным блокам
+    Interval       joint;         // H(S_i, S_{i+1}) [бит на пару]
+    Interval       conditional;   // H(S_{i+1} | S_i) [бит на ниббл]
+    std::uint64_t  file_size  = 0;
+    std::uint64_t  bytes_read = 0;
+    std::size_t    blocks     = 0;
+    bool           exact      = false; // файл прочитан целиком подряд
+
+    Scheme scheme() const { return Scheme(counts); }
+};
+
+namespace detail
+{
+
+using BlockCounts = std::array<std::uint32_t, 256>; // N_ab одного блока, a*16+b
+
+struct Block
+{
+    std::uint64_t index = 0; // номер блока в файле
+    BlockCounts   counts{};
+};
+
+// Номер страты блока idx при делении population блоков на strata равных страт
+// (границы те же, что у раунда выборки: population * s / strata)
+inline std::uint64_t stratum_of(std::uint64_t idx, std::uint64_t population, std::uint64_t strata)
+{
+    std::uint64_t s = std::min(strata - 1, idx * strata / population);
+    while (s > 0 && population * s / strata > idx) --s;
+    while (s + 1 < strata && population * (s + 1) / strata <= idx) ++s;
+    return s;
+}
+
+// Интервал по дельта-методу с учётом кластеризации по блокам:
+// линеаризуем H через его градиент по p_ab и считаем дисперсию вклада блоков.
+// Выборка стратифицирована, поэтому дисперсия считается внутри страт
+// последнего раунда (strata равных страт), а не по всей выборке: различия
+// между областями файла в неё не попадают. Страты, где оказался один блок,
+// сливаются с соседней (collapsed strata) — на первом раунде это пары соседей.
+inline void fill_intervals(const std::vector<Block>& blocks,
+                           std::uint64_t strata,
+                           std::uint64_t population,
+                           std::uint64_t full_transitions,
+                           const Options& opt,
+                           Estimate& est)
+{
+    std::array<std::uint64_t, 256> total{};
+    std::array<std::uint64_t, 16>  rows{};
+    for (const auto& b : blocks) {
+        for (int i = 0; i < 256; ++i) total[i] += b.counts[i];
+    }
+
+    std::uint64_t N = 0;
+    for (int a = 0; a < 16; ++a) {
+        for (int b = 0; b < 16; ++b) {
+            est.counts[a][b] = total[a * 16 + b];
+            rows[a] += total[a * 16 + b];
+        }
+        N += rows[a];
+    }
+
+    if (N == 0) {
+        est.joint = {};
+        est.conditional = {};
+        return;
+    }
+
+    // -log2 P(a,b) и -log2 P(b|a) для каждой ячейки
+    std::array<double, 256> lj{};
+    std::array<double, 256> lc{};
+    double Hj = 0.0;
+    double Hc = 0.0;
+    for (int a = 0; a < 16; ++a) {
+        for (int b = 0; b < 16; ++b) {
+            const std::uint64_t n = total[a * 16 + b];
+            if (!n) continue;
+            lj[a * 16 + b] = -std::log2(static_cast<double>(n) / static_cast<double>(N));
+            lc[a * 16 + b] = -std::log2(static_cast<double>(n) / static_cast<double>(rows[a]));
+            Hj += static_cast<double>(n) * lj[a * 16 + b];
+            Hc += static_cast<double>(n) * lc[a * 16 + b];
+        }
+    }
+    Hj /= static_cast<double>(N);
+    Hc /= static_cast<double>(N);
+
+    // Поправка Миллера-Мэдоу: по выборке энтропия занижена примерно на
+    // (K-1)/(2N ln2), а на полном файле — на (K-1)/(2N_full ln2).
+    // Сдвигаем оценку к значению, которое дал бы полный проход.
+    int Kj = 0;
+    int Kr = 0;
+    for (int a = 0; a < 16; ++a) {
+        if (rows[a]) ++Kr;
+        for (int b = 0; b < 16; ++b) {
+            if (total[a * 16 + b]) ++Kj;
+        }
+    }
+    const double shrink = (1.0 / static_cast<double>(N)
+                         - 1.0 / static_cast<double>(std::max(N, full_transitions)))
+                        / (2.0 * std::log(2.0));
+    Hj += (Kj - 1) * shrink;
+    Hc += (Kj - Kr) * shrink;
+
+    const std::size_t m = blocks.size();
+    double half_j = std::numeric_limits<double>::infinity();
+    double half_c = std::numeric_limits<double>::infinity();
+    if (m >= 2) {
+        // Линеаризованные вклады блоков в порядке их положения в файле
+        std::vector<const Block*> order;
+        order.reserve(m);
+        for (const auto& b : blocks) order.push_back(&b);
+        std::sort(order.begin(), order.end(),
+                  [](const Block* a, const Block* b) { return a->index < b->index; });
+
+        std::vector<double> us(m);
+        std::vector<double> vs(m);
+        for (std::size_t j = 0; j < m; ++j) {
+            const BlockCounts& bc = order[j]->counts;
+            double u = 0.0;
+            double v = 0.0;
+            double nj = 0.0;
+            for (int i = 0; i < 256; ++i) {
+                if (!bc[i]) continue;
+                const double n = static_cast<double>(bc[i]);
+                u  += n * lj[i];
+                v  += n * lc[i];
+                nj += n;
+            }
+            us[j] = u - nj * Hj;
+            vs[j] = v - nj * Hc;
+        }
+
+        // Слитые страты: пары соседних страт последнего раунда, то есть
+        // примерно по четыре блока в группе. Внутри одной страты два блока
+        // стоят слишком близко и недооценивают разброс, когда граница
+        // однородного участка не совпадает с границей страты.
+        const std::uint64_t groups = std::max<std::uint64_t>(1, strata / 2);
+        std::vector<std::size_t> starts;
+        for (std::size_t j = 0; j < m; ) {
+            std::size_t e = j;
+            const std::uint64_t sj = stratum_of(order[j]->index, population, groups);
+            while (e < m && stratum_of(order[e]->index, population, groups) == sj) ++e;
+            if (e - j < 2 && e < m) {
+                // Одиночку сливаем со следующей группой целиком
+                const std::uint64_t sn = stratum_of(order[e]->index, population, groups);
+                while (e < m && stratum_of(order[e]->index, population, groups) == sn) ++e;
+            }
+            starts.push_back(j);
+            j = e;
+        }
+        if (starts.size() > 1 && m - starts.back() < 2) {
+            starts.pop_back(); // последняя одиночка — к предыдущей группе
+        }
+        starts.push_back(m);
+
+        // Var(sum u) = sum_g k/(k-1) * sum_{i in g} (u_i - mean_g)^2
+        double su = 0.0;
+        double sv = 0.0;
+        for (std::size_t g = 0; g + 1 < starts.size(); ++g) {
+            const std::size_t b = starts[g];
+            const std::size_t e = starts[g + 1];
+            const double k = static_cast<double>(e - b);
+            double mu = 0.0;
+            double mv = 0.0;
+            for (std::size_t j = b; j < e; ++j) {
+                mu += us[j];
+                mv += vs[j];
+            }
+            mu /= k;
+            mv /= k;
+            double du = 0.0;
+            double dv = 0.0;
+            for (std::size_t j = b; j < e; ++j) {
+                du += (us[j] - mu) * (us[j] - mu);
+                dv += (vs[j] - mv) * (vs[j] - mv);
+            }
+            su += k / (k - 1.0) * du;
+            sv += k / (k - 1.0) * dv;
+        }
+
+        // Поправка на конечную совокупность: при полном покрытии дисперсия -> 0
+        const double fpc = std::max(0.0, 1.0 - static_cast<double>(m) / static_cast<double>(population));
+        const double NN  = static_cast<double>(N) * static_cast<double>(N);
+        half_j = opt.z * std::sqrt(fpc * su / NN);
+        half_c = opt.z * std::sqrt(fpc * sv / NN);
+    }
+
+    Hj = std::min(8.0, std::max(0.0, Hj));
+    Hc = std::min(4.0, std::max(0.0, Hc));
+    est.joint       = { Hj, std::max(0.0, Hj - half_j), std::min(8.0, Hj + half_j) };
+    est.conditional = { Hc, std::max(0.0, Hc - half_c), std::min(4.0, Hc + half_c) };
+}
+
+} // namespace detail
+
+// Пошаговая выборка: каждый refine() — один раунд. Маленький файл первым же
+// раундом читается целиком (exact).
+class Sampler
+{
+public:
+    explicit Sampler(const std::string& path, const Options& opt = {});
+
+    // Следующий раунд; ничего не делает, если оценка уже окончательная
+    void refine();
+    // Точность достигнута, выборка упёрлась в max_blocks или файл прочитан целиком
+    bool done() const { return m_done; }
+    const Estimate& current() const { return m_est; }
+
+private:
+    void read_exact();
+    void read_block(std::uint64_t idx);
+
+    std::string                  m_path;
+    Options                      m_opt;
+    std::ifstream                m_file;
+    Estimate                     m_est;
+    std::uint64_t                m_population = 0;
+    std::size_t                  m_cap = 0;
+    std::size_t                  m_round = 0; // страт в следующем раунде
+    bool                         m_done = false;
+    std::mt19937_64              m_rng;
+    std::vector<bool>            m_taken;
+    std::vector<detail::Block>   m_blocks;
+    std::vector<std::uint8_t>    m_buf;
+    TransitionCounter            m_counter;
+};
+
+inline Sampler::Sampler(const std::string& path, const Options& opt)
+    : m_path(path)
+    , m_opt(opt)
+    , m_file(path, std::ios::binary)
+    , m_rng(opt.seed)
+{
+    if (m_opt.block_size == 0 || m_opt.initial_blocks == 0) {
+        throw std::runtime_error("Invalid sampling options");
+    }
+    if (!m_file) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+
+    m_file.seekg(0, std::ios::end);
+    const std::streampos sz = m_file.tellg();
+    if (sz < std::streampos{0}) {
+        throw std::runtime_error("Cannot determine file size: " + path);
+    }
+    m_file.seekg(0, std::ios::beg);
+
+    m_est.file_size = static_cast<std::uint64_t>(sz);
+    m_population = (m_est.file_size + m_opt.block_size - 1) / m_opt.block_size;
+    m_cap = static_cast<std::size_t>(
+        std::min<std::uint64_t>(m_population, std::max(m_opt.max_blocks, m_opt.initial_blocks)));
+    m_round = m_opt.initial_blocks;
+    m_buf.resize(m_opt.block_size);
+}
+
+inline void Sampler::read_exact()
+{
+    while (m_file) {
+        m_file.read(reinterpret_cast<char*>(m_buf.data()), static_cast<std::streamsize>(m_buf.size()));
+        const std::streamsize got = m_file.gcount();
+        if (got <= 0) break;
+        m_counter.feed(m_buf.data(), static_cast<std::size_t>(got));
+    }
+    if (m_counter.processed() != m_est.file_size) {
+        throw std::runtime_error("Failed to read entire file: " + m_path);
+    }
+
+    const Scheme sch = m_counter.scheme();
+    m_est.counts      = m_counter.counts();
+    m_est.bytes_read  = m_counter.processed();
+    m_est.blocks      = static_cast<std::size_t>(m_population);
+    m_est.exact       = true;
+    m_est.joint       = { sch.entropy_joint(), sch.entropy_joint(), sch.entropy_joint() };
+    m_est.conditional = { sch.entropy_conditional_nibble(),
+                          sch.entropy_conditional_nibble(),
+                          sch.entropy_conditional_nibble() };
+}
+
+inline void Sampler::read_block(std::uint64_t idx)
+{
+    const std::uint64_t off = idx * m_opt.block_size;
+    const std::size_t   len = static_cast<std::size_t>(
+        std::min<std::uint64_t>(m_opt.block_size, m_est.file_size - off));
+
+    m_file.clear();
+    m_file.seekg(static_cast<std::streamoff>(off), std::ios::beg);
+    m_file.read(reinterpret_cast<char*>(m_buf.data()), static_cast<std::streamsize>(len));
+    if (m_file.gcount() != static_cast<std::streamsize>(len)) {
+        throw std::runtime_error("Failed to read block from file: " + m_path);
+    }
+
+    m_counter.reset();
+    m_counter.feed(m_buf.data(), len);
+
+    detail::Block b;
+    b.index = idx;
+    const auto& c = m_counter.counts();
+    for (int a = 0; a < 16; ++a) {
+        for (int k = 0; k < 16; ++k) {
+            b.counts[a * 16 + k] = static_cast<std::uint32_t>(c[a][k]);
+        }
+    }
+    m_blocks.push_back(b);
+    m_est.bytes_read += len;
+}
+
+inline void Sampler::refine()
+{
+    if (m_done) {
+        return;
+    }
+
+    // Маленький файл — дешевле посчитать точно
+    if (m_population <= m_opt.initial_blocks) {
+        read_exact();
+        m_done = true;
+        return;
+    }
+
+    if (m_taken.empty()) {
+        m_taken.assign(static_cast<std::size_t>(m_population), false);
+        m_blocks.reserve(m_cap);
+    }
+
+    // Стратифицированный раунд: по одному случайному блоку из каждой из
+    // m_round равных страт; занятые блоки обходим внутри своей страты
+    const std::size_t strata = m_round;
+    for (std::size_t s = 0; s < m_round && m_blocks.size() < m_cap; ++s) {
+        const std::uint64_t lo = m_population * s / m_round;
+        const std::uint64_t hi = m_population * (s + 1) / m_round;
+        if (hi <= lo) continue;
+
+        const std::uint64_t width = hi - lo;
+        const std::uint64_t start = std::uniform_int_distribution<std::uint64_t>(0, width - 1)(m_rng);
+        for (std::uint64_t k = 0; k < width; ++k) {
+            const std::uint64_t idx = lo + (start + k) % width;
+            if (!m_taken[static_cast<std::size_t>(idx)]) {
+                m_taken[static_cast<std::size_t>(idx)] = true;
+                read_block(idx);
+                break;
+            }
+        }
+    }
+
+    detail::fill_intervals(m_blocks, strata, m_population, 2 * m_est.file_size - 1, m_opt, m_est);
+    m_est.blocks = m_blocks.size();
+
+    const bool precise = m_est.joint.half_width() <= m_opt.precision
+                      && m_est.conditional.half_width() <= m_opt.precision;
+    m_done = precise || m_blocks.size() >= m_cap;
+
+    // Следующий раунд удваивает выборку
+    m_round = std::min(m_blocks.size(), m_cap - m_blocks.size());
+}
+
+inline Estimate estimate(const std::string& path, const Options& opt = {})
+{
+    Sampler sampler(path, opt);
+    while (!sampler.done()) {
+        sampler.refine();
+    }
+    return sampler.current();
+}
+
+} // namespace nibble_sampling
+
+#endif // NIBBLE_SAMPLING_H
@@ -0,0 +1,438 @@
+#pragma once
+#ifndef NIBBLE_SEGMENTATION_H
+#define NIBBLE_SEGMENTATION_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "scheme.h"
+#include "transition_counter.h"
+#include "nibbles_io.h"
+
+// Разбиение файла на однородные области по статистике переходов.
+//
+// Файл режется на блоки, для границ блоков запоминаются префиксные счётчики
+// N_ab, поэтому счётчики любого отрезка — разность двух префиксов (O(256)).
+// Стоимость отрезка — минус логарифм правдоподобия марковской модели
+// (N * H(S_{i+1} | S_i) бит); точки смены ищутся бинарной сегментацией со
+// штрафом BIC за каждую новую область.
+namespace nibble_segmentation
+{
+
+enum class Label
+{
+    Padding,      // почти константные данные (заполнение, нули)
+    Structured,   // код, текст, таблицы
+    HighEntropy   // сжатые или зашифрованные данные
+};
+
+inline const char* label_name(Label label)
+{
+    switch (label) {
+    case Label::Padding:     return "padding";
+    case Label::Structured:  return "structured";
+    case Label::HighEntropy: return "high-entropy";
+    }
+    return "unknown";
+}
+
+struct Options
+{
+    std::size_t block_size         = 4096;  // минимальный размер блока, байт
+    std::size_t max_blocks         = 8192;  // больше — блок растёт (память prefix)
+    std::size_t min_segment_blocks = 4;     // минимальная длина области, блоков
+    std::size_t max_segments       = 256;
+    double      penalty            = 0.0;   // штраф за область, бит; 0 — BIC
+    double      padding_below      = 0.5;   // H(S_{i+1}|S_i) ниже — padding
+    double      high_entropy_above = 3.7;   // H(S_{i+1}|S_i) выше — high-entropy
+    bool        merge_same_label   = true;  // склеивать соседей с одной меткой
+};
+
+struct Segment
+{
+    std::uint64_t  begin = 0;        // смещение начала, байт
+    std::uint64_t  end   = 0;        // смещение конца (не включая), байт
+    Label          label = Label::Structured;
+    Scheme::Counts counts{};         // N_ab области
+    double         joint       = 0.0; // H(S_i, S_{i+1})
+    double         conditional = 0.0; // H(S_{i+1} | S_i)
+
+    Scheme scheme() const { return Scheme(counts); }
+};
+
+// Накапливает префиксные счётчики по мере подачи данных.
+// Полный размер нужен заранее, чтобы выбрать размер блока.
+class Segmenter
+{
+public:
+    explicit Segmenter(std::uint64_t total_size, const Options& opt = {})
+        : m_opt(opt)
+    {
+        if (m_opt.block_size == 0 || m_opt.max_blocks == 0) {
+            throw std::runtime_error("Invalid segmentation options");
+        }
+
+        const std::uint64_t by_count = (total_size + m_opt.max_blocks - 1) / m_opt.max_blocks;
+        m_block = std::max<std::uint64_t>(m_opt.block_size, by_count);
+        m_prefix.reserve(static_cast<std::size_t>((total_size + m_block - 1) / m_block + 1));
+        m_prefix.push_back(Flat{});
+    }
+
+    void feed(const std::uint8_t* data, std::size_t size)
+    {
+        while (size > 0) {
+            const std::uint64_t room = m_block - m_in_block;
+            const std::size_t   take = static_cast<std::size_t>(std::min<std::uint64_t>(room, size));
+
+            m_counter.feed(data, take);
+            m_in_block += take;
+            data += take;
+            size -= take;
+
+            if (m_in_block == m_block) {
+                snapshot();
+            }
+        }
+    }
+
+    // Сумма по всему поданному — то же, что даёт полный проход
+    const TransitionCounter& counter() const { return m_counter; }
+    std::uint64_t processed() const { return m_counter.processed(); }
+
+    std::vector<Segment> segments() const
+    {
+        // Недописанный последний блок тоже участвует: его префикс — текущие
+        // счётчики, m_prefix при этом не копируется
+        const Flat tail = flatten(m_counter.counts());
+        const Prefix prefix{ m_prefix, tail };
+
+        const std::size_t n = m_prefix.size() - 1 + (m_in_block > 0 ? 1 : 0);
+        if (n == 0) {
+            return {};
+        }
+
+        const std::size_t min_len = std::max<std::size_t>(1, m_opt.min_segment_blocks);
+        const double penalty = (m_opt.penalty > 0.0)
+            ? m_opt.penalty
+            : 0.5 * 240.0 * std::log2(std::max<double>(2.0, static_cast<double>(m_counter.transitions())));
+
+        // Бинарная сегментация: делим отрезок в лучшей точке, пока выигрыш
+        // в стоимости больше штрафа
+        std::vector<std::size_t> cuts = { 0, n };
+        std::vector<std::pair<std::size_t, std::size_t>> work = { { 0, n } };
+        while (!work.empty() && cuts.size() - 1 < m_opt.max_segments) {
+            const auto [s, e] = work.back();
+            work.pop_back();
+            if (e - s < 2 * min_len) continue;
+
+            const double whole = cost(prefix, s, e);
+            double best = whole;
+            std::size_t best_t = 0;
+            for (std::size_t t = s + min_len; t + min_len <= e; ++t) {
+                const double c = cost(prefix, s, t) + cost(prefix, t, e);
+                if (c < best) {
+                    best = c;
+                    best_t = t;
+                }
+            }
+
+            if (best_t != 0 && whole - best > penalty) {
+                cuts.push_back(best_t);
+                work.push_back({ s, best_t });
+                work.push_back({ best_t, e });
+            }
+        }
+        std::sort(cuts.begin(), cuts.end());
+
+        std::vector<Segment> out;
+        for (std::size_t i = 0; i + 1 < cuts.size(); ++i) {
+            std::size_t s = cuts[i];
+            const std::size_t e = cuts[i + 1];
+            Segment seg = make_segment(prefix, s, e);
+
+            if (m_opt.merge_same_label && !out.empty() && out.back().label == seg.label) {
+                // Пересчитываем объединённую область по префиксам
+                s = static_cast<std::size_t>(out.back().begin / m_block);
+                const Label label = out.back().label;
+                seg = make_segment(prefix, s, e);
+                seg.label = label;
+                out.back() = seg;
+                continue;
+            }
+            out.push_back(seg);
+        }
+
+        return out;
+    }
+
+    std::uint64_t block_size() const { return m_block; }
+
+    // Сохранить префиксные счётчики, чтобы продолжить после перезагрузки.
+    // Блоки укрупняются до не более чем SAVE_MAX_BLOCKS, приращения N_ab по
+    // блокам пишутся varint — запись занимает порядка сотен КиБ.
+    void save(std::ostream& out) const;
+    static Segmenter load(std::istream& in, const Options& opt = {});
+
+    static constexpr std::size_t SAVE_MAX_BLOCKS = 1024;
+
+private:
+    using Flat = std::array<std::uint64_t, 256>; // N_ab в порядке строк
+
+    // Префиксы полных блоков, за которыми идёт префикс недописанного
+    struct Prefix
+    {
+        const std::vector<Flat>& full;
+        const Flat&              tail;
+
+        const Flat& operator[](std::size_t i) const { return i < full.size() ? full[i] : tail; }
+    };
+
+    static Flat flatten(const Scheme::Counts& c)
+    {
+        Flat f{};
+        for (int a = 0; a < 16; ++a) {
+            for (int b = 0; b < 16; ++b) {
+                f[a * 16 + b] = c[a][b];
+            }
+        }
+        return f;
+    }
+
+    void snapshot()
+    {
+        m_prefix.push_back(flatten(m_counter.counts()));
+        m_in_block = 0;
+
+        // Файл вырос сильно больше ожидаемого (дозапись) — укрупняем блоки,
+        // чтобы память под префиксы оставалась ограниченной
+        if (m_prefix.size() > 2 * m_opt.max_blocks + 1) {
+            coarsen();
+        }
+    }
+
+    // Удвоить размер блока: оставить префиксы только на чётных границах
+    void coarsen()
+    {
+        const std::size_t full = m_prefix.size() - 1; // число полных блоков
+        std::size_t j = 0;
+        for (std::size_t i = 0; i <= full; i += 2) {
+            m_prefix[j++] = m_prefix[i];
+        }
+        m_prefix.resize(j);
+
+        // Последний нечётный блок становится началом недописанного
+        if (full % 2) {
+            m_in_block += m_block;
+        }
+        m_block *= 2;
+    }
+
+    static double xlog2x(std::uint64_t n)
+    {
+        return n ? static_cast<double>(n) * std::log2(static_cast<double>(n)) : 0.0;
+    }
+
+    // N * H(S_{i+1} | S_i) = sum_a N_a log N_a - sum_ab N_ab log N_ab
+    static double cost(const Prefix& prefix, std::size_t s, std::size_t e)
+    {
+        const Flat& lo = prefix[s];
+        const Flat& hi = prefix[e];
+        double c = 0.0;
+        for (int a = 0; a < 16; ++a) {
+            std::uint64_t row = 0;
+            for (int b = 0; b < 16; ++b) {
+                const std::uint64_t n = hi[a * 16 + b] - lo[a * 16 + b];
+                row += n;
+                c -= xlog2x(n);
+            }
+            c += xlog2x(row);
+        }
+        return c;
+    }
+
+    Segment make_segment(const Prefix& prefix, std::size_t s, std::size_t e) const
+    {
+        Segment seg;
+        seg.begin = static_cast<std::uint64_t>(s) * m_block;
+        seg.end   = std::min<std::uint64_t>(static_cast<std::uint64_t>(e) * m_block, m_counter.processed());
+        for (int a = 0; a < 16; ++a) {
+            for (int b = 0; b < 16; ++b) {
+                seg.counts[a][b] = prefix[e][a * 16 + b] - prefix[s][a * 16 + b];
+            }
+        }
+
+        const Scheme sch(seg.counts);
+        seg.joint       = sch.entropy_joint();
+        seg.conditional = sch.entropy_conditional_nibble();
+
+        if (seg.conditional < m_opt.padding_below) {
+            seg.label = Label::Padding;
+        } else if (seg.conditional > m_opt.high_entropy_above) {
+            seg.label = Label::HighEntropy;
+        } else {
+            seg.label = Label::Structured;
+        }
+        return seg;
+    }
+
+    Options           m_opt;
+    std::uint64_t     m_block{0};
+    std::uint64_t     m_in_block{0};
+    TransitionCounter m_counter;
+    std::vector<Flat> m_prefix; // m_prefix[i] — N_ab по первым i блокам
+};
+
+namespace detail
+{
+
+const char          SEGMENTER_MAGIC[8] = { 'N', 'B', 'L', 'S', 'E', 'G', 'M', 'T' };
+const std::uint64_t SEGMENTER_VERSION  = 1;
+
+inline void put_varint(std::ostream& out, std::uint64_t v)
+{
+    while (v >= 0x80) {
+        out.put(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.put(static_cast<char>(v));
+}
+
+inline std::uint64_t get_varint(std::istream& in)
+{
+    std::uint64_t v = 0;
+    for (int shift = 0; shift <= 63; shift += 7) {
+        const int c = in.get();
+        if (c == std::char_traits<char>::eof()) {
+            break;
+        }
+        v |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+        if (!(c & 0x80)) {
+            return v;
+        }
+    }
+    throw std::runtime_error("Truncated segmentation state");
+}
+
+} // namespace detail
+
+// Формат (little-endian): "NBLSEGMT", u64 версия, u64 размер блока,
+// u64 байт в недописанном блоке, счётчик (u64 processed, u64 last | 0x100 при
+// has_last, 256 x u64 N_ab), u64 число полных блоков, по каждому блоку
+// 256 varint-приращений N_ab
+inline void Segmenter::save(std::ostream& out) const
+{
+    using nibble_io::put_u64;
+
+    Segmenter s = *this;
+    while (s.m_prefix.size() - 1 > SAVE_MAX_BLOCKS) {
+        s.coarsen();
+    }
+
+    out.write(detail::SEGMENTER_MAGIC, 8);
+    put_u64(out, detail::SEGMENTER_VERSION);
+    put_u64(out, s.m_block);
+    put_u64(out, s.m_in_block);
+    put_u64(out, s.m_counter.processed());
+    put_u64(out, static_cast<std::uint64_t>(s.m_counter.last()) | (s.m_counter.has_last() ? 0x100u : 0u));
+    for (const auto& r : s.m_counter.counts()) {
+        for (std::uint64_t n : r) put_u64(out, n);
+    }
+
+    put_u64(out, s.m_prefix.size() - 1);
+    for (std::size_t i = 1; i < s.m_prefix.size(); ++i) {
+        for (int k = 0; k < 256; ++k) {
+            detail::put_varint(out, s.m_prefix[i][k] - s.m_prefix[i - 1][k]);
+        }
+    }
+
+    if (!out) {
+        throw std::runtime_error("Failed to write segmentation state");
+    }
+}
+
+inline Segmenter Segmenter::load(std::istream& in, const Options& opt)
+{
+    using nibble_io::get_u64;
+
+    char magic[8] = {};
+    in.read(magic, 8);
+    if (!in || !std::equal(magic, magic + 8, detail::SEGMENTER_MAGIC)) {
+        throw std::runtime_error("Not a segmentation state");
+    }
+    if (get_u64(in) != detail::SEGMENTER_VERSION) {
+        throw std::runtime_error("Unsupported segmentation state version");
+    }
+
+    Segmenter s(0, opt);
+    s.m_block    = get_u64(in);
+    s.m_in_block = get_u64(in);
+    const std::uint64_t processed = get_u64(in);
+    const std::uint64_t last      = get_u64(in);
+
+    TransitionCounter::Counts counts{};
+    for (auto& r : counts) {
+        for (auto& n : r) n = get_u64(in);
+    }
+
+    const std::uint64_t blocks = get_u64(in);
+    if (!in || s.m_block == 0 || s.m_in_block >= s.m_block
+        || blocks > 2 * std::max<std::uint64_t>(SAVE_MAX_BLOCKS, s.m_opt.max_blocks)
+        || processed != blocks * s.m_block + s.m_in_block) {
+        throw std::runtime_error("Corrupted segmentation state");
+    }
+    s.m_counter.restore(counts, processed, static_cast<uchar>(last & 0x0F), (last & 0x100u) != 0);
+
+    s.m_prefix.resize(static_cast<std::size_t>(blocks) + 1);
+    for (std::size_t i = 1; i < s.m_prefix.size(); ++i) {
+        for (int k = 0; k < 256; ++k) {
+            s.m_prefix[i][k] = s.m_prefix[i - 1][k] + detail::get_varint(in);
+        }
+    }
+    const Flat total = flatten(counts);
+    for (int k = 0; k < 256; ++k) {
+        if (s.m_prefix.back()[k] > total[k]) {
+            throw std::runtime_error("Corrupted segmentation state");
+        }
+    }
+
+    return s;
+}
+
+inline std::vector<Segment> segment_bytes(const std::uint8_t* data, std::size_t size,
+                                          const Options& opt = {})
+{
+    Segmenter seg(size, opt);
+    seg.feed(data, size);
+    return seg.segments();
+}
+
+inline std::vector<Segment> segment_file(const std::string& path, const Options& opt = {})
+{
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    if (!f) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    const std::streampos sz = f.tellg();
+    if (sz < std::streampos{0}) {
+        throw std::runtime_error("Cannot determine file size: " + path);
+    }
+    f.close();
+
+    Segmenter seg(static_cast<std::uint64_t>(sz), opt);
+    nibble_io::feed_file(path, seg);
+    return seg.segments();
+}
+
+} // namespace nibble_segmentation
+
+#endif // NIBBLE_SEGMENTATION_H
@@ -1,18 +1,24 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <cstddef>
 #include <cstdint>
 #include <fstream>
+#include <istream>
+#include <ostream>
 #include <stdexcept>
 
 #include "nibble.h"
+#include "transition_counter.h"
 
 namespace nibble_io
 {
 
-inline std::vector<std::uint8_t> read_to_bin(const std::string& path)
+// Читает файл в out, переиспользуя его ёмкость: при повторных вызовах с тем же
+// вектором память выделяется, только если файл больше всех предыдущих
+inline void read_to_bin(const std::string& path, std::vector<std::uint8_t>& out)
 {
     std::ifstream f(path, std::ios::binary);
     if (!f) {
@@ -26,14 +32,19 @@ inline std::vector<std::uint8_t> read_to_bin(const std::string& path)
     }
     f.seekg(0, std::ios::beg);
 
-    std::vector<std::uint8_t> bytes(static_cast<std::size_t>(sz));
+    out.resize(static_cast<std::size_t>(sz));
     if (sz > 0) {
-        f.read(reinterpret_cast<char*>(bytes.data()), sz);
+        f.read(reinterpret_cast<char*>(out.data()), sz);
         if (f.gcount() != static_cast<std::streamsize>(sz)) {
             throw std::runtime_error("Failed to read entire file: " + path);
         }
     }
+}
 
+inline std::vector<std::uint8_t> read_to_bin(const std::string& path)
+{
+    std::vector<std::uint8_t> bytes;
+    read_to_bin(path, bytes);
     return bytes;
 }
 
@@ -58,6 +69,59 @@ inline std::vector<Nibble> file_to_nibbles(const std::string& path)
     return convert_to_nibbles(bytes);
 }
 
+// Потоково подаёт файл, начиная со смещения offset, кусками по chunk байт
+// в counter (TransitionCounter или любой приёмник с feed(const uint8_t*, size_t)),
+// не загружая его в память целиком. Если cancel выставлен — прерывается и
+// возвращает false.
+template <class Counter>
+bool feed_file_from(const std::string& path,
+                    std::uint64_t offset,
+                    Counter& counter,
+                    const std::atomic<bool>* cancel = nullptr,
+                    std::size_t chunk = std::size_t{1} << 20)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    if (offset > 0) {
+        f.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+        if (!f) {
+            throw std::runtime_error("Cannot seek in file: " + path);
+        }
+    }
+
+    std::vector<std::uint8_t> buf(chunk);
+    while (f) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        f.read(reinterpret_cast<char*>(buf.data()), static_cast<std::streamsize>(buf.size()));
+        const std::streamsize got = f.gcount();
+        if (got <= 0) {
+            break;
+        }
+        counter.feed(buf.data(), static_cast<std::size_t>(got));
+    }
+
+    if (f.bad()) {
+        throw std::runtime_error("Failed to read file: " + path);
+    }
+
+    return true;
+}
+
+// То же с начала файла
+template <class Counter>
+bool feed_file(const std::string& path,
+               Counter& counter,
+               const std::atomic<bool>* cancel = nullptr,
+               std::size_t chunk = std::size_t{1} << 20)
+{
+    return feed_file_from(path, 0, counter, cancel, chunk);
+}
+
 inline void write_nibbles_to_file(const std::string& path,
                                   const std::vector<Nibble>& nibbles)
 {
@@ -90,6 +154,23 @@ inline void write_nibbles_to_file(const std::string& path,
     }
 }
 
+// u64 little-endian в поток и обратно — для двоичных форматов состояния
+// (Segmenter::save/load, записи кэша результатов)
+inline void put_u64(std::ostream& out, std::uint64_t v)
+{
+    char b[8];
+    for (int i = 0; i < 8; ++i) b[i] = static_cast<char>(v >> (8 * i));
+    out.write(b, 8);
+}
+
+inline std::uint64_t get_u64(std::istream& in)
+{
+    unsigned char b[8] = {};
+    in.read(reinterpret_cast<char*>(b), 8);
+    std::uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | b[i];
+    return v;
+}
 
 } // namespace nibble_io
 
@@ -19,34 +19,24 @@ public:
     explicit Scheme(const std::vector<Nibble>& seq)
     {
         for (auto& r : m_counts) r.fill(0);
-        m_row_sum.fill(0);
-        m_total = 0;
 
         if (seq.size() >= 2) {
             for (size_t i = 0; i + 1 < seq.size(); ++i) {
                 const int a = seq[i].value();     // 0..15
                 const int b = seq[i+1].value();   // 0..15
                 m_counts[a][b] += 1;
-                m_row_sum[a]   += 1;
-                ++m_total;
             }
         }
 
-        // Совместные P(a,b)
-        for (int a = 0; a < 16; ++a) {
-            for (int b = 0; b < 16; ++b) {
-                m_joint[a][b] = (m_total ? static_cast<double>(m_counts[a][b]) / static_cast<double>(m_total) : 0.0);
-            }
-        }
+        build();
+    }
 
-        // Условные P(b|a)
-        for (int a = 0; a < 16; ++a) {
-            const uint64_t Na = m_row_sum[a];
-            const double invNa = (Na ? 1.0 / static_cast<double>(Na) : 0.0);
-            for (int b = 0; b < 16; ++b) {
-                m_cond[a][b] = (Na ? static_cast<double>(m_counts[a][b]) * invNa : 0.0);
-            }
-        }
+    // Строим схему по уже накопленным счётчикам N_ab
+    // (потоковый подсчёт, выборочная оценка и т.п.)
+    explicit Scheme(const Counts& counts)
+        : m_counts(counts)
+    {
+        build();
     }
 
     // === Доступ к данным ===
@@ -104,6 +94,35 @@ public:
     double entropy_max() const { return 4.0; }
 
 private:
+    // Суммы по строкам, общее число переходов и обе матрицы вероятностей
+    void build()
+    {
+        m_row_sum.fill(0);
+        m_total = 0;
+        for (int a = 0; a < 16; ++a) {
+            for (int b = 0; b < 16; ++b) {
+                m_row_sum[a] += m_counts[a][b];
+            }
+            m_total += m_row_sum[a];
+        }
+
+        // Совместные P(a,b)
+        for (int a = 0; a < 16; ++a) {
+            for (int b = 0; b < 16; ++b) {
+                m_joint[a][b] = (m_total ? static_cast<double>(m_counts[a][b]) / static_cast<double>(m_total) : 0.0);
+            }
+        }
+
+        // Условные P(b|a)
+        for (int a = 0; a < 16; ++a) {
+            const uint64_t Na = m_row_sum[a];
+            const double invNa = (Na ? 1.0 / static_cast<double>(Na) : 0.0);
+            for (int b = 0; b < 16; ++b) {
+                m_cond[a][b] = (Na ? static_cast<double>(m_counts[a][b]) * invNa : 0.0);
+            }
+        }
+    }
+
     Counts                   m_counts{};   // N_ab
     std::array<uint64_t,16>  m_row_sum{};  // N_a
     uint64_t                 m_total{0};   // N
@@ -0,0 +1,102 @@
+#pragma once
+#ifndef TRANSITION_COUNTER_H
+#define TRANSITION_COUNTER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "scheme.h"
+
+// Потоковый подсчёт переходов N_ab прямо по байтам, без промежуточного
+// std::vector<Nibble>. Данные можно подавать кусками: последний ниббл
+// предыдущего куска запоминается, и переход через границу не теряется.
+class TransitionCounter
+{
+public:
+    using Counts = Scheme::Counts;
+
+    TransitionCounter() { reset(); }
+
+    void reset()
+    {
+        for (auto& r : m_counts) r.fill(0);
+        m_total     = 0;
+        m_processed = 0;
+        m_last      = 0;
+        m_has_last  = false;
+    }
+
+    // Восстановить ранее сохранённое состояние (см. Segmenter::load)
+    void restore(const Counts& counts, std::uint64_t processed, uchar last, bool has_last)
+    {
+        m_counts    = counts;
+        m_processed = processed;
+        m_last      = static_cast<uchar>(last & 0x0F);
+        m_has_last  = has_last;
+
+        m_total = 0;
+        for (const auto& r : m_counts) {
+            for (std::uint64_t n : r) m_total += n;
+        }
+    }
+
+    // Добавить очередной кусок байтов (старшая тетрада идёт первой)
+    void feed(const std::uint8_t* data, std::size_t size)
+    {
+        if (size == 0) {
+            return;
+        }
+
+        std::size_t i = 0;
+        unsigned last = m_last;
+        if (!m_has_last) {
+            // Самый первый байт: переход только внутри него
+            const unsigned hi = (data[0] >> 4) & 0x0Fu;
+            const unsigned lo = data[0] & 0x0Fu;
+            m_counts[hi][lo] += 1;
+            last = lo;
+            i = 1;
+        }
+
+        for (; i < size; ++i) {
+            const unsigned hi = (data[i] >> 4) & 0x0Fu;
+            const unsigned lo = data[i] & 0x0Fu;
+            m_counts[last][hi] += 1; // переход с предыдущего байта
+            m_counts[hi][lo]   += 1; // переход внутри байта
+            last = lo;
+        }
+
+        m_total     += 2 * static_cast<std::uint64_t>(size) - (m_has_last ? 0 : 1);
+        m_processed += size;
+        m_last       = static_cast<uchar>(last);
+        m_has_last   = true;
+    }
+
+    void feed(const std::vector<std::uint8_t>& bytes)
+    {
+        feed(bytes.data(), bytes.size());
+    }
+
+    // Сырые счётчики N_ab
+    const Counts& counts() const { return m_counts; }
+    // Общее число переходов N
+    std::uint64_t transitions() const { return m_total; }
+    // Сколько байтов уже подано
+    std::uint64_t processed() const { return m_processed; }
+    // Последний ниббл (значим, только если has_last())
+    uchar last() const { return m_last; }
+    bool has_last() const { return m_has_last; }
+
+    Scheme scheme() const { return Scheme(m_counts); }
+
+private:
+    Counts        m_counts{};
+    std::uint64_t m_total{0};
+    std::uint64_t m_processed{0};
+    uchar         m_last{0};
+    bool          m_has_last{false};
+};
+
+#endif // TRANSITION_COUNTER_H
@@ -3,24 +3,38 @@
 
 #include <QDir>
 #include <QAction>
+#include <QApplication>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
 #include <QHeaderView>
 #include <QMessageBox>
+#include <QSettings>
+#include <QStandardPaths>
 #include <QLabel>
 #include <QStatusBar>
 #include <QTableView>
+#include <QThread>
+#include <QTimer>
 
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "scheme_model.h"
+#include "segment_bar.h"
 
 // core
 #include "nibble.h"
 #include "scheme.h"
 #include "nibbles_io.h"
 #include "nibble_intervals.h"
+#include "nibble_cache.h"
+#include "nibble_container.h"
+#include "nibble_incremental.h"
+#include "nibble_sampling.h"
+#include "nibble_segmentation.h"
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
@@ -41,6 +55,7 @@ MainWindow::MainWindow(QWidget* parent)
     m_lblH    = ui->lblH;
     m_lblHmax = ui->lblHmax;
     m_lblHref = ui->lblHref;
+    m_segmentBar = ui->segmentBar;
 
     // Начальные значения
     if (m_lblN)    m_lblN->setText("–");
@@ -55,10 +70,37 @@ MainWindow::MainWindow(QWidget* parent)
     connect(ui->actionExit, &QAction::triggered, this, &QWidget::close);
     connect(ui->actionPack, &QAction::triggered, this, &MainWindow::packFile);
     connect(ui->actionUnpack, &QAction::triggered, this, &MainWindow::unpackFile);
+    connect(ui->actionPackDir, &QAction::triggered, this, &MainWindow::packDirectory);
+    connect(ui->actionUnpackDir, &QAction::triggered, this, &MainWindow::unpackContainer);
+
+    // Кэш результатов: повторное открытие неизменного файла не перечитывает его.
+    // Проверка полным хэшем читает файл целиком и по умолчанию выключена.
+    m_cacheDir =
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/results");
+    const bool verify = QSettings().value(QStringLiteral("cache/verify"), false).toBool();
+    m_cache = std::make_shared<ResultCache>(m_cacheDir.toStdString(), ResultCache::DEFAULT_MAX_BYTES, verify);
+    ui->actionVerifyCache->setChecked(verify);
+    connect(ui->actionVerifyCache, &QAction::toggled, this, &MainWindow::setVerifyCache);
+
+    // Режим слежения: дочитываем файл по мере записи в него
+    m_watcher = new QFileSystemWatcher(this);
+    m_followTimer = new QTimer(this);
+    m_followTimer->setSingleShot(true);
+    m_followTimer->setInterval(300);
+    connect(ui->actionFollow, &QAction::toggled, this, &MainWindow::setFollow);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &MainWindow::onWatchedFileChanged);
+    connect(m_followTimer, &QTimer::timeout, this, &MainWindow::followUpdate);
 }
 
 MainWindow::~MainWindow()
 {
+    // Фоновые потоки — дети окна: просим остановиться и дожидаемся,
+    // в том числе записи дочитанного состояния в кэш
+    cancelExactScan();
+    storeState();
+    for (QThread* t : findChildren<QThread*>()) {
+        t->wait();
+    }
     delete ui;
 }
 
@@ -197,42 +239,481 @@ void MainWindow::unpackFile()
     }
 }
 
+void MainWindow::packDirectory()
+{
+    const QString sourceDir = QFileDialog::getExistingDirectory(
+        this,
+        tr("Выбор папки для упаковки")
+    );
+    if (sourceDir.isEmpty()) {
+        return;
+    }
+
+    // Имя по умолчанию = имя папки + .nibbles рядом с ней
+    const QDir dir(sourceDir);
+    const QString initialPath =
+        QFileInfo(dir.absolutePath()).dir().filePath(dir.dirName() + QStringLiteral(".nibbles"));
+
+    QString archivePath = QFileDialog::getSaveFileName(
+        this,
+        tr("Сохранить контейнер как"),
+        initialPath,
+        tr("Nibble контейнеры (*.nibbles)")
+    );
+    if (archivePath.isEmpty()) {
+        return;
+    }
+
+    if (!archivePath.endsWith(QStringLiteral(".nibbles"), Qt::CaseInsensitive)) {
+        archivePath += QStringLiteral(".nibbles");
+    }
+
+    const std::string dirPath = sourceDir.toStdString();
+    const std::string outPath = archivePath.toStdString();
+    const QString     name    = QFileInfo(archivePath).fileName();
+    runContainerJob(
+        tr("Упаковка папки: %1").arg(name),
+        [dirPath, outPath]() {
+            NibbleContainerArchiever archiever;
+            archiever.pack_directory(dirPath, outPath);
+        },
+        tr("Папка упакована: %1").arg(name),
+        tr("Не удалось упаковать папку:\n%1")
+    );
+}
+
+void MainWindow::unpackContainer()
+{
+    const QString archivePath = QFileDialog::getOpenFileName(
+        this,
+        tr("Выбор контейнера .nibbles"),
+        QString(),
+        tr("Nibble контейнеры (*.nibbles);;Все файлы (*.*)")
+    );
+    if (archivePath.isEmpty()) {
+        return;
+    }
+
+    const QString targetDir = QFileDialog::getExistingDirectory(
+        this,
+        tr("Папка для распаковки"),
+        QFileInfo(archivePath).dir().absolutePath()
+    );
+    if (targetDir.isEmpty()) {
+        return;
+    }
+
+    const std::string inPath  = archivePath.toStdString();
+    const std::string dirPath = targetDir.toStdString();
+    const QString     name    = QFileInfo(archivePath).fileName();
+    runContainerJob(
+        tr("Распаковка контейнера: %1").arg(name),
+        [inPath, dirPath]() {
+            NibbleContainerArchiever archiever;
+            archiever.unpack_all(inPath, dirPath);
+        },
+        tr("Контейнер распакован: %1").arg(name),
+        tr("Не удалось распаковать контейнер:\n%1")
+    );
+}
+
+void MainWindow::runContainerJob(const QString& busy,
+                                 std::function<void()> job,
+                                 const QString& done,
+                                 const QString& failed)
+{
+    // Пока идёт одна операция, вторую не начинаем: обе могли бы писать
+    // в одни и те же файлы
+    ui->actionPackDir->setEnabled(false);
+    ui->actionUnpackDir->setEnabled(false);
+    statusBar()->showMessage(busy);
+
+    auto error = std::make_shared<std::string>();
+    QThread* thread = QThread::create([job = std::move(job), error]() {
+        try
+        {
+            job();
+        }
+        catch (const std::exception& e)
+        {
+            *error = e.what();
+        }
+        catch (...)
+        {
+            *error = "Unknown error";
+        }
+    });
+    thread->setParent(this);
+
+    connect(thread, &QThread::finished, this, [this, thread, error, done, failed]() {
+        thread->deleteLater();
+        ui->actionPackDir->setEnabled(true);
+        ui->actionUnpackDir->setEnabled(true);
+
+        if (!error->empty()) {
+            statusBar()->clearMessage();
+            QMessageBox::critical(this, tr("Ошибка"),
+                                  failed.arg(QString::fromLocal8Bit(error->c_str())));
+            return;
+        }
+        statusBar()->showMessage(done, 4000);
+    });
+
+    thread->start();
+}
+
 void MainWindow::loadFile(const QString& path)
 {
-    try 
-    {
-        // 1) читаем файл → нибблы
-        std::vector<Nibble> nibbleSequence = nibble_io::file_to_nibbles(path.toStdString());
-
-        // 2) считаем схему переходов
-        Scheme sch(std::move(nibbleSequence));
-        const auto& T = sch.table(); // std::array<std::array<double,16>,16>
-
-        // 3) обновляем модель таблицы
-        SchemeModel::Matrix M = T;
-        m_model->setMatrix(M);
-
-        // 4) метрики
-        const double H    = sch.entropy_joint();
-        const double Hmax = sch.entropy_max();
-        const double Hrel = (Hmax > 0.0) ? (H / Hmax) : 0.0;
-
-        if (m_lblN)    m_lblN->setText(QString::number(static_cast<qulonglong>(sch.transitions())));
-        if (m_lblH)    m_lblH->setText(QString::number(H, 'f', 4));
-        if (m_lblHmax) m_lblHmax->setText(QString::number(Hmax, 'f', 4));
-        if (m_lblHref) m_lblHref->setText(QString::number(Hrel, 'f', 4));
-
-        statusBar()->showMessage(tr("Загружено: %1").arg(QFileInfo(path).fileName()), 4000);
-    } 
-    catch (const std::exception& e) 
-    {
-        QMessageBox::critical(this, tr("Ошибка"),
-                              tr("Не удалось обработать файл:\n%1")
-                              .arg(QString::fromLocal8Bit(e.what())));
-    } 
-    catch (...) 
+    cancelExactScan();
+
+    if (m_currentPath != path) {
+        storeState(); // дочитанное состояние прошлого файла
+        m_currentPath = path;
+        if (ui->actionFollow->isChecked()) {
+            setFollow(true); // следим уже за новым файлом
+        }
+    }
+
+    // Повторная загрузка того же файла: дочитываем только добавленные байты
+    if (m_segmenter && m_statePath == path) {
+        statusBar()->showMessage(tr("Проверка изменений: %1").arg(QFileInfo(path).fileName()));
+        startScan(path, std::move(m_segmenter), m_fingerprint);
+        return;
+    }
+
+    m_segmenter.reset();
+    m_statePath.clear();
+    m_stat.reset();
+    if (m_segmentBar) m_segmentBar->clear();
+
+    // Кэш, выборочная оценка и точный проход — в фоновом потоке: при
+    // проверке кэша полным хэшем поиск записи сам читает весь файл
+    statusBar()->showMessage(tr("Загрузка: %1").arg(QFileInfo(path).fileName()));
+    startScan(path, nullptr, 0);
+}
+
+void MainWindow::startScan(const QString& path,
+                           std::shared_ptr<nibble_segmentation::Segmenter> base,
+                           std::uint64_t fingerprint)
+{
+    using nibble_incremental::Update;
+
+    struct ScanResult
     {
-        QMessageBox::critical(this, tr("Ошибка"),
-                              tr("Неизвестная ошибка при обработке файла."));
+        Update                                          update = Update::Cancelled;
+        bool                                            cached = false; // взято из кэша как есть
+        std::shared_ptr<nibble_segmentation::Segmenter> segmenter;
+        std::uint64_t                                   fingerprint = 0;
+        FileStat                                        stat;
+        std::optional<Scheme>                           scheme;
+        std::vector<nibble_segmentation::Segment>       segments;
+        std::string                                     error;
+    };
+
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    auto result = std::make_shared<ScanResult>();
+    const std::string stdPath = path.toStdString();
+    const quint64 size = static_cast<quint64>(QFileInfo(path).size());
+    const QString name = QFileInfo(path).fileName();
+
+    // Состояние base переходит потоку целиком: при отмене оно теряется,
+    // и следующая загрузка просто пересчитает файл
+    QThread* thread = QThread::create([this, stdPath, size, name, base, fingerprint, cache = m_cache, cancel, result]() mutable {
+        using nibble_segmentation::Segmenter;
+
+        // Промежуточный результат — окну; лямбда с контекстом this
+        // выполнится в потоке окна
+        auto post = [this, cancel](auto show) {
+            QMetaObject::invokeMethod(this, [cancel, show]() {
+                if (!cancel->load()) show();
+            }, Qt::QueuedConnection);
+        };
+
+        try
+        {
+            if (!base) {
+                // 0) файл не менялся или только вырос с прошлого анализа —
+                //    продолжаем с результата из кэша
+                if (auto hit = cache->find(stdPath)) {
+                    base        = std::make_shared<Segmenter>(std::move(hit->segmenter));
+                    fingerprint = hit->fingerprint;
+                    if (base->processed() >= size) {
+                        result->scheme      = base->counter().scheme();
+                        result->segments    = base->segments();
+                        result->segmenter   = std::move(base);
+                        result->fingerprint = fingerprint;
+                        result->stat        = hit->stat;
+                        result->update      = Update::Unchanged;
+                        result->cached      = true;
+                        return;
+                    }
+
+                    post([this, scheme = base->counter().scheme(), segments = base->segments(), name]() {
+                        showScheme(scheme);
+                        if (m_segmentBar) m_segmentBar->setSegments(segments);
+                        statusBar()->showMessage(tr("Загружено из кэша, дочитываются новые данные: %1").arg(name));
+                    });
+                } else {
+                    // 1) выборочная оценка по раундам: каждую промежуточную
+                    //    оценку показываем, пока не достигнута точность
+                    nibble_sampling::Sampler sampler(stdPath);
+                    while (!sampler.done() && !cancel->load()) {
+                        sampler.refine();
+                        post([this, est = sampler.current()]() {
+                            if (est.exact) {
+                                showScheme(est.scheme()); // файл прочитан целиком
+                            } else {
+                                showEstimate(est);
+                            }
+                        });
+                    }
+                }
+                if (cancel->load()) {
+                    return;
+                }
+            }
+
+            // Метаданные — до чтения: изменение файла во время прохода
+            // даст промах кэша, а не устаревший результат
+            const FileStat stat = FileStat::of(stdPath);
+
+            // 2) точный проход с сегментацией. Сегментатор заодно накапливает
+            //    полные счётчики; если префикс файла изменился, update()
+            //    начинает его заново
+            auto segmenter = base ? base : std::make_shared<Segmenter>(size);
+            std::uint64_t fp = base ? fingerprint : 0;
+            const Update update = nibble_incremental::update(stdPath, *segmenter, fp,
+                [&stdPath](Segmenter& s) { s = Segmenter(nibble_incremental::file_size(stdPath)); },
+                cancel.get());
+            if (update == Update::Cancelled) {
+                return;
+            }
+
+            if (update != Update::Unchanged) {
+                result->scheme   = segmenter->counter().scheme();
+                result->segments = segmenter->segments();
+            }
+            result->fingerprint = fp;
+            result->stat        = stat;
+
+            // Полный проход сохраняем сразу; дочитанное — в storeState(),
+            // иначе режим слежения писал бы в кэш при каждом обновлении
+            if (update == Update::Rescanned) {
+                try
+                {
+                    CachedResult cached;
+                    cached.segmenter   = *segmenter;
+                    cached.fingerprint = fp;
+                    cached.stat        = stat;
+                    cache->store(stdPath, cached);
+                }
+                catch (...)
+                {
+                    // Кэш — только ускорение: ошибки записи не мешают анализу
+                }
+            }
+
+            result->segmenter   = std::move(segmenter);
+            result->update      = update;
+        }
+        catch (const std::exception& e)
+        {
+            result->error = e.what();
+        }
+        catch (...)
+        {
+            result->error = "Unknown error";
+        }
+    });
+    thread->setParent(this);
+
+    connect(thread, &QThread::finished, this, [this, thread, cancel, result, path, name]() {
+        thread->deleteLater();
+        if (cancel->load()) {
+            return; // пользователь уже открыл другой файл
+        }
+        m_scanCancel.reset();
+
+        if (!result->error.empty()) {
+            QMessageBox::critical(this, tr("Ошибка"),
+                                  tr("Не удалось обработать файл:\n%1")
+                                  .arg(QString::fromLocal8Bit(result->error.c_str())));
+            return;
+        }
+
+        if (result->segmenter) {
+            m_statePath   = path;
+            m_segmenter   = std::move(result->segmenter);
+            m_fingerprint = result->fingerprint;
+            m_stat        = std::make_shared<FileStat>(result->stat);
+            if (result->update == Update::Appended) {
+                m_cacheDirty = true;
+            } else if (result->update == Update::Rescanned) {
+                m_cacheDirty = false;
+            }
+        }
+
+        if (result->scheme) {
+            showScheme(*result->scheme);
+            if (m_segmentBar) m_segmentBar->setSegments(std::move(result->segments));
+        }
+
+        switch (result->update) {
+        case Update::Appended:
+            statusBar()->showMessage(tr("Дочитаны новые данные: %1").arg(name), 4000);
+            break;
+        case Update::Unchanged:
+            statusBar()->showMessage(result->cached ? tr("Загружено из кэша: %1").arg(name)
+                                                    : tr("Без изменений: %1").arg(name), 4000);
+            break;
+        case Update::Rescanned:
+            statusBar()->showMessage(tr("Загружено: %1").arg(name), 4000);
+            break;
+        case Update::Cancelled:
+            break;
+        }
+
+        // Пока шёл подсчёт, файл успел измениться ещё раз
+        if (m_followPending) {
+            m_followPending = false;
+            followUpdate();
+        }
+    });
+
+    m_scanCancel = cancel;
+    thread->start();
+}
+
+void MainWindow::setFollow(bool on)
+{
+    const QStringList watched = m_watcher->files();
+    if (!watched.isEmpty()) {
+        m_watcher->removePaths(watched);
+    }
+    m_followPending = false;
+
+    if (!on) {
+        storeState();
+    }
+
+    if (on && !m_currentPath.isEmpty()) {
+        m_watcher->addPath(m_currentPath);
+    }
+}
+
+void MainWindow::onWatchedFileChanged(const QString& path)
+{
+    if (path != m_currentPath) {
+        return;
+    }
+
+    // Файл пересоздан (ротация логов и т.п.) — наблюдатель его теряет
+    if (!m_watcher->files().contains(path) && QFileInfo::exists(path)) {
+        m_watcher->addPath(path);
+    }
+
+    // Записи приходят пачками — обновляемся не чаще раза в интервал
+    m_followTimer->start();
+}
+
+void MainWindow::followUpdate()
+{
+    if (m_currentPath.isEmpty() || !ui->actionFollow->isChecked()) {
+        return;
+    }
+
+    // Не прерываем идущий подсчёт: обновимся, когда он закончится
+    if (m_scanCancel) {
+        m_followPending = true;
+        return;
     }
+
+    loadFile(m_currentPath);
+}
+
+void MainWindow::cancelExactScan()
+{
+    if (m_scanCancel) {
+        m_scanCancel->store(true);
+        m_scanCancel.reset();
+    }
+}
+
+void MainWindow::storeState()
+{
+    if (!m_cacheDirty) {
+        return;
+    }
+    m_cacheDirty = false;
+    if (!m_segmenter || !m_stat) {
+        return;
+    }
+
+    CachedResult cached;
+    cached.segmenter   = *m_segmenter;
+    cached.fingerprint = m_fingerprint;
+    cached.stat        = *m_stat;
+
+    // С проверкой запись считает полный хэш файла — не в потоке окна
+    QThread* thread = QThread::create([cache = m_cache, path = m_statePath.toStdString(), cached]() {
+        try
+        {
+            cache->store(path, cached);
+        }
+        catch (...)
+        {
+            // Кэш — только ускорение: ошибки записи не мешают анализу
+        }
+    });
+    thread->setParent(this);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
+}
+
+void MainWindow::setVerifyCache(bool on)
+{
+    QSettings().setValue(QStringLiteral("cache/verify"), on);
+
+    // Идущие потоки дорабатывают с прежним экземпляром, новые загрузки
+    // пойдут через этот
+    m_cache = std::make_shared<ResultCache>(m_cacheDir.toStdString(), ResultCache::DEFAULT_MAX_BYTES, on);
+}
+
+void MainWindow::showScheme(const Scheme& sch)
+{
+    const auto& T = sch.table(); // std::array<std::array<double,16>,16>
+
+    SchemeModel::Matrix M = T;
+    m_model->setMatrix(M);
+
+    const double H    = sch.entropy_joint();
+    const double Hmax = sch.entropy_max();
+    const double Hrel = (Hmax > 0.0) ? (H / Hmax) : 0.0;
+
+    if (m_lblN)    m_lblN->setText(QString::number(static_cast<qulonglong>(sch.transitions())));
+    if (m_lblH)    m_lblH->setText(QString::number(H, 'f', 4));
+    if (m_lblHmax) m_lblHmax->setText(QString::number(Hmax, 'f', 4));
+    if (m_lblHref) m_lblHref->setText(QString::number(Hrel, 'f', 4));
+}
+
+void MainWindow::showEstimate(const nibble_sampling::Estimate& est)
+{
+    showScheme(est.scheme());
+
+    // Поверх showScheme(): помечаем значения как приближённые и
+    // добавляем полуширину доверительного интервала
+    const double Hmax = est.scheme().entropy_max();
+    const double H    = est.joint.value;
+    const double dH   = est.joint.half_width();
+
+    if (m_lblN)    m_lblN->setText(QStringLiteral("≈ %1").arg(static_cast<qulonglong>(2 * est.file_size - 1)));
+    if (m_lblH)    m_lblH->setText(QStringLiteral("≈ %1 ± %2").arg(H, 0, 'f', 4).arg(dH, 0, 'f', 4));
+    if (m_lblHref) m_lblHref->setText(QStringLiteral("≈ %1 ± %2").arg(H / Hmax, 0, 'f', 4).arg(dH / Hmax, 0, 'f', 4));
+
+    statusBar()->showMessage(
+        tr("Оценка по %1 блокам (%2%), идёт точный подсчёт: %3")
+            .arg(static_cast<qulonglong>(est.blocks))
+            .arg(100.0 * static_cast<double>(est.bytes_read) / static_cast<double>(est.file_size), 0, 'f', 1)
+            .arg(QFileInfo(m_currentPath).fileName())
+    );
 }
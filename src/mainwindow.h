@@ -1,13 +1,27 @@
 #pragma once
 #include <QMainWindow>
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
 class QTableView;
 class QLabel;
+class QFileSystemWatcher;
+class QTimer;
 class SchemeModel;
+class Scheme;
+class SegmentBar;
+class ResultCache;
+struct FileStat;
+
+namespace nibble_sampling { struct Estimate; }
+namespace nibble_segmentation { class Segmenter; }
 
 class MainWindow : public QMainWindow
 {
@@ -21,10 +35,39 @@ private slots:
     void openFile();
     void packFile();
     void unpackFile();
+    void packDirectory();
+    void unpackContainer();
+
+    void setFollow(bool on);
+    void onWatchedFileChanged(const QString& path);
+    void followUpdate();
+
+    // Сверять записи кэша с полным хэшем файла (настройка сохраняется)
+    void setVerifyCache(bool on);
 
 private:
     void loadFile(const QString& path);
 
+    // Точный подсчёт в фоновом потоке; по завершении заменяет оценку.
+    // Без base поток сначала ищет файл в кэше, а при промахе показывает
+    // выборочную оценку по раундам. Если передано состояние прошлого прохода
+    // и префикс файла не изменился, дочитываются только добавленные байты.
+    void startScan(const QString& path,
+                   std::shared_ptr<nibble_segmentation::Segmenter> base,
+                   std::uint64_t fingerprint);
+    void cancelExactScan();
+    // Упаковка или распаковка контейнера в фоновом потоке: на время работы
+    // пункты меню контейнеров недоступны, итог — в строке состояния
+    void runContainerJob(const QString& busy,
+                         std::function<void()> job,
+                         const QString& done,
+                         const QString& failed);
+    // Записать в кэш дочитанное, но ещё не сохранённое состояние
+    void storeState();
+
+    void showScheme(const Scheme& sch);
+    void showEstimate(const nibble_sampling::Estimate& est);
+
     Ui::MainWindow* ui = nullptr;
 
     SchemeModel* m_model = nullptr;
@@ -35,4 +78,25 @@ private:
     QLabel*     m_lblH  = nullptr;
     QLabel*     m_lblHmax = nullptr;
     QLabel*     m_lblHref = nullptr;
+    SegmentBar* m_segmentBar = nullptr;
+
+    // Флаг отмены текущего фонового подсчёта
+    std::shared_ptr<std::atomic<bool>> m_scanCancel;
+
+    // Открытый файл и состояние его последнего полного прохода
+    QString m_currentPath;
+    QString m_statePath;
+    std::shared_ptr<nibble_segmentation::Segmenter> m_segmenter;
+    std::uint64_t m_fingerprint = 0;
+    std::shared_ptr<FileStat> m_stat; // метаданные файла перед последним проходом
+    bool m_cacheDirty = false;        // состояние дочитано, но не записано в кэш
+
+    // Дисковый кэш результатов (общий с фоновыми потоками)
+    QString                      m_cacheDir;
+    std::shared_ptr<ResultCache> m_cache;
+
+    // Слежение за файлом
+    QFileSystemWatcher* m_watcher = nullptr;
+    QTimer*             m_followTimer = nullptr;
+    bool                m_followPending = false;
 };
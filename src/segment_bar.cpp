@@ -0,0 +1,141 @@
+#include "segment_bar.h"
+
+#include <QColor>
+#include <QFontMetrics>
+#include <QHelpEvent>
+#include <QPainter>
+#include <QString>
+#include <QToolTip>
+
+#include <utility>
+
+namespace
+{
+
+QColor labelColor(nibble_segmentation::Label label)
+{
+    switch (label) {
+    case nibble_segmentation::Label::Padding:     return QColor(190, 190, 190);
+    case nibble_segmentation::Label::Structured:  return QColor(110, 160, 220);
+    case nibble_segmentation::Label::HighEntropy: return QColor(225, 105, 90);
+    }
+    return Qt::white;
+}
+
+QString labelText(nibble_segmentation::Label label)
+{
+    switch (label) {
+    case nibble_segmentation::Label::Padding:     return QObject::tr("заполнение");
+    case nibble_segmentation::Label::Structured:  return QObject::tr("структура");
+    case nibble_segmentation::Label::HighEntropy: return QObject::tr("высокая энтропия");
+    }
+    return {};
+}
+
+} // namespace
+
+SegmentBar::SegmentBar(QWidget* parent)
+    : QWidget(parent)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+void SegmentBar::setSegments(std::vector<nibble_segmentation::Segment> segments)
+{
+    m_segments = std::move(segments);
+    m_total = m_segments.empty() ? 0 : m_segments.back().end;
+    update();
+}
+
+void SegmentBar::clear()
+{
+    m_segments.clear();
+    m_total = 0;
+    update();
+}
+
+QSize SegmentBar::sizeHint() const
+{
+    return QSize(400, fontMetrics().height() + 10);
+}
+
+QSize SegmentBar::minimumSizeHint() const
+{
+    return QSize(50, fontMetrics().height() + 10);
+}
+
+QRect SegmentBar::segmentRect(const nibble_segmentation::Segment& s) const
+{
+    const double w = static_cast<double>(width());
+    const int x0 = static_cast<int>(w * static_cast<double>(s.begin) / static_cast<double>(m_total));
+    const int x1 = static_cast<int>(w * static_cast<double>(s.end)   / static_cast<double>(m_total));
+    return QRect(x0, 0, qMax(1, x1 - x0), height());
+}
+
+int SegmentBar::segmentAt(int x) const
+{
+    if (m_total == 0) {
+        return -1;
+    }
+    for (int i = 0; i < static_cast<int>(m_segments.size()); ++i) {
+        const QRect r = segmentRect(m_segments[static_cast<std::size_t>(i)]);
+        if (x >= r.left() && x <= r.right()) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void SegmentBar::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event);
+
+    QPainter p(this);
+    p.fillRect(rect(), palette().window());
+    if (m_total == 0) {
+        return;
+    }
+
+    const QFontMetrics fm = fontMetrics();
+    for (const auto& s : m_segments) {
+        const QRect r = segmentRect(s);
+        p.fillRect(r, labelColor(s.label));
+        p.setPen(palette().window().color());
+        p.drawLine(r.topLeft(), r.bottomLeft());
+
+        // Подпись — только если помещается
+        const QString text = labelText(s.label);
+        if (fm.horizontalAdvance(text) + 8 < r.width()) {
+            p.setPen(Qt::black);
+            p.drawText(r, Qt::AlignCenter, text);
+        }
+    }
+}
+
+bool SegmentBar::event(QEvent* event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        auto* help = static_cast<QHelpEvent*>(event);
+        const int i = segmentAt(help->pos().x());
+        if (i < 0) {
+            QToolTip::hideText();
+            event->ignore();
+            return true;
+        }
+
+        const auto& s = m_segments[static_cast<std::size_t>(i)];
+        QToolTip::showText(
+            help->globalPos(),
+            tr("%1\n0x%2 – 0x%3 (%4 байт)\nH: %5, H усл: %6")
+                .arg(labelText(s.label))
+                .arg(static_cast<qulonglong>(s.begin), 0, 16)
+                .arg(static_cast<qulonglong>(s.end), 0, 16)
+                .arg(static_cast<qulonglong>(s.end - s.begin))
+                .arg(s.joint, 0, 'f', 4)
+                .arg(s.conditional, 0, 'f', 4),
+            this
+        );
+        return true;
+    }
+    return QWidget::event(event);
+}
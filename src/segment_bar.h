@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QWidget>
+
+#include <vector>
+
+#include "nibble_segmentation.h"
+
+// Полоса под таблицей: области файла, раскрашенные по метке сегментации.
+// Подсказка при наведении показывает диапазон и энтропии области.
+class SegmentBar : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SegmentBar(QWidget* parent = nullptr);
+
+    void setSegments(std::vector<nibble_segmentation::Segment> segments);
+    void clear();
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    bool event(QEvent* event) override;
+
+private:
+    // Индекс области под координатой x или -1
+    int segmentAt(int x) const;
+    QRect segmentRect(const nibble_segmentation::Segment& s) const;
+
+    std::vector<nibble_segmentation::Segment> m_segments;
+    quint64 m_total = 0;
+};